@@ -258,6 +258,8 @@ typedef struct _win       /* definition of a window */
     chtype **_y;          /* pointer to line pointer array */
     int   *_firstch;      /* first changed character in line */
     int   *_lastch;       /* last changed character in line */
+    unsigned long *_dirty; /* bitmap of lines that may have changed */
+    int   *_spans;        /* changed ranges in each line, or NULL */
     int   _tmarg;         /* top of scrolling region */
     int   _bmarg;         /* bottom of scrolling region */
     int   _delayms;       /* milliseconds of delay for getch() */
@@ -324,6 +326,35 @@ typedef struct
     attr_t termattrs;     /* attribute capabilities */
 } SCREEN;
 
+/* Work done by the refresh code; see PDC_get_refresh_stats() */
+
+typedef struct
+{
+    unsigned long frames;      /* doupdate() calls that drew */
+    unsigned long lines;       /* lines of curscr looked at */
+    unsigned long compared;    /* cells compared */
+    unsigned long changed;     /* cells sent to the platform layer */
+    unsigned long runs;        /* runs sent to the platform layer */
+    unsigned long scrolls;     /* regions scrolled */
+    unsigned long copied;      /* bytes copied between screen images */
+    unsigned long refresh_us;  /* time in wnoutrefresh(), pnoutrefresh() */
+    unsigned long update_us;   /* time in doupdate(), in all */
+    unsigned long platform_us; /* time in the platform layer */
+    unsigned long rects;       /* rects updated (SDL) */
+    unsigned long presents;    /* screen updates (SDL) */
+} PDC_REFRESH_STATS;
+
+/* Window pool usage; see PDC_get_window_pool() */
+
+typedef struct
+{
+    unsigned long in_use;      /* blocks allocated to windows */
+    unsigned long cached;      /* free blocks held for reuse */
+    unsigned long cached_bytes;
+    unsigned long hits;        /* allocations served from the pool */
+    unsigned long misses;      /* allocations passed to malloc() */
+} PDC_WINDOW_POOL;
+
 /*----------------------------------------------------------------------
  *
  *  PDCurses External Variables
@@ -1327,6 +1358,19 @@ PDCEX  void    PDC_debug(const char *, ...);
 PDCEX  int     PDC_ungetch(int);
 PDCEX  int     PDC_set_blink(bool);
 PDCEX  int     PDC_set_bold(bool);
+PDCEX  int     PDC_set_damage_spans(bool);
+PDCEX  int     PDC_set_max_fps(int);
+PDCEX  int     PDC_get_refresh_stats(PDC_REFRESH_STATS *,
+                                     PDC_REFRESH_STATS *);
+PDCEX  int     PDC_reset_refresh_stats(void);
+PDCEX  int     PDC_set_window_pool(bool);
+PDCEX  int     PDC_reserve_windows(int, int, int);
+PDCEX  int     PDC_get_window_pool(PDC_WINDOW_POOL *);
+PDCEX  int     PDC_set_paged_pads(bool);
+PDCEX  WINDOW  *PDC_map_pad(const char *, int, int);
+PDCEX  int     PDC_blit(WINDOW *, int, int, const chtype *, int, int, int);
+PDCEX  int     PDC_blit_key(WINDOW *, int, int, const chtype *, int, int,
+                            int, chtype);
 PDCEX  int     PDC_set_line_color(short);
 PDCEX  void    PDC_set_title(const char *);
 
@@ -22,6 +22,13 @@
 # endif
 #endif
 
+#if defined(__linux__) || defined(__APPLE__) || defined(__FreeBSD__) || \
+    defined(__NetBSD__) || defined(__OpenBSD__)
+# ifndef HAVE_MMAP
+#  define HAVE_MMAP          /* have mmap(), for PDC_map_pad() */
+# endif
+#endif
+
 /*----------------------------------------------------------------------*/
 
 typedef struct           /* structure for ripped off lines */
@@ -30,16 +37,59 @@ typedef struct           /* structure for ripped off lines */
     int (*init)(WINDOW *, int);
 } RIPPEDOFFLINE;
 
+typedef struct           /* a run of changed cells, for
+                            PDC_transform_frame() */
+{
+    int y, x, len;
+    const chtype *text;  /* points into curscr */
+} FRAMERUN;
+
 /* Window properties */
 
 #define _SUBWIN    0x01  /* window is a subwindow */
 #define _PAD       0x10  /* X/Open Pad. */
 #define _SUBPAD    0x20  /* X/Open subpad. */
+#define _PAGED     0x40  /* pad with lines allocated as written */
+#define _MAPPED    0x80  /* pad with lines in a mapped file */
 
 /* Miscellaneous */
 
 #define _NO_CHANGE -1    /* flags line edge unchanged */
 
+#define PDC_DUMPVER 3    /* version of the putwin() format; should be
+                            updated whenever the WINDOW struct is
+                            changed */
+
+/* Each window also keeps a bitmap with a bit set for every line whose
+   _firstch may be set, so doupdate() can find changed lines in curscr
+   without looking at every one. Anything that sets _firstch must also
+   set the bit; bits are only cleared by doupdate(). */
+
+#define PDC_DIRTY_BITS     (sizeof(unsigned long) * 8)
+#define PDC_DIRTY_WORDS(n) (((n) + PDC_DIRTY_BITS - 1) / PDC_DIRTY_BITS)
+#define PDC_DIRTY_BIT(win, y) \
+    ((win)->_dirty[(y) / PDC_DIRTY_BITS] |= 1UL << ((y) % PDC_DIRTY_BITS))
+
+/* With PDC_set_damage_spans() on, _spans holds, for each line, a count
+   followed by up to PDC_MAXSPANS sorted first/last column pairs. A
+   count of zero means only _firstch and _lastch are known. Changes
+   recorded by PDC_add_span() keep the list; PDC_SET_DIRTY() is for
+   everything else, and falls back to _firstch/_lastch. */
+
+#define PDC_MAXSPANS     4
+#define PDC_SPAN_STRIDE  (1 + 2 * PDC_MAXSPANS)
+#define PDC_SET_DIRTY(win, y) \
+    (PDC_DIRTY_BIT(win, y), (void)((win)->_spans && \
+     ((win)->_spans[(y) * PDC_SPAN_STRIDE] = 0)))
+
+/* The lines of a paged pad (see PDC_set_paged_pads()) that haven't been
+   written to all point to one shared blank line. Anything that writes
+   to a window's line must get it through PDC_LINE(), which gives it
+   storage of its own first, and returns NULL if that fails. */
+
+#define PDC_LINE(win, y) \
+    (((win)->_flags & _PAGED) ? PDC_page_line(win, y) : (win)->_y[y])
+
 #define _ECHAR     0x08  /* Erase char       (^H) */
 #define _DWCHAR    0x17  /* Delete Word char (^W) */
 #define _DLCHAR    0x15  /* Delete Line char (^U) */
@@ -67,6 +117,8 @@ int     PDC_get_rows(void);
 void    PDC_gotoyx(int, int);
 int     PDC_init_color(short, short, short, short);
 void    PDC_init_pair(short, short, short);
+unsigned long PDC_ms_count(void);
+unsigned long PDC_us_count(void);
 int     PDC_modifiers_set(void);
 int     PDC_mouse_set(void);
 void    PDC_napms(int);
@@ -79,23 +131,44 @@ void    PDC_save_screen_mode(int);
 void    PDC_scr_close(void);
 void    PDC_scr_free(void);
 int     PDC_scr_open(int, char **);
+bool    PDC_scroll_region(int, int, int);
 void    PDC_set_keyboard_binary(bool);
 void    PDC_transform_line(int, int, int, const chtype *);
+bool    PDC_transform_frame(const FRAMERUN *, int, int, int);
 const char *PDC_sysname(void);
 
 /* Internal cross-module functions */
 
+void    PDC_add_span(WINDOW *, int, int, int);
+int     PDC_ascii_run(const char *, int);
+int     PDC_attr_run(const chtype *, int, chtype);
+void    PDC_cells_init(void);
+int     PDC_first_diff(const chtype *, const chtype *, int);
+int     PDC_first_same(const chtype *, const chtype *, int);
+int     PDC_last_diff(const chtype *, const chtype *, int);
 void    PDC_init_atrtab(void);
+chtype *PDC_blank_line(WINDOW *);
 WINDOW *PDC_makelines(WINDOW *);
 WINDOW *PDC_makenew(int, int, int, int);
+WINDOW *PDC_makepages(WINDOW *);
 int     PDC_mouse_in_slk(int, int);
+bool    PDC_page_clear(WINDOW *, int, chtype);
+chtype *PDC_page_line(WINDOW *, int);
+void    PDC_printw_free(void);
+void    PDC_refresh_flush(void);
+void    PDC_refresh_free(void);
+void    PDC_refresh_pending(void);
+int     PDC_shift_lines(WINDOW *, int, int, int);
 void    PDC_slk_free(void);
 void    PDC_slk_initialize(void);
 void    PDC_sync(WINDOW *);
+void    PDC_sync_lastscr(void);
+void    PDC_unmap_pad(WINDOW *);
 
 #ifdef PDC_WIDE
 int     PDC_mbtowc(wchar_t *, const char *, size_t);
 size_t  PDC_mbstowcs(wchar_t *, const char *, size_t);
+int     PDC_mbsntowcs(wchar_t *, int, const char *, int, int *);
 size_t  PDC_wcstombs(char *, const wchar_t *, size_t);
 #endif
 
@@ -105,6 +178,22 @@ size_t  PDC_wcstombs(char *, const wchar_t *, size_t);
 # define PDC_LOG(x)
 #endif
 
+/* Refresh statistics, if built with PDC_STATS. pdc_stats holds the
+   counts for the frame in progress; times are taken from the port's
+   PDC_us_count(). PDC_STAT_START() declares a variable, so it goes at
+   the end of the declarations. */
+
+#ifdef PDC_STATS
+extern PDC_REFRESH_STATS pdc_stats;
+# define PDC_STAT(field, n)       (pdc_stats.field += (n))
+# define PDC_STAT_START(t)        unsigned long t = PDC_us_count()
+# define PDC_STAT_TIME(field, t)  (pdc_stats.field += PDC_us_count() - (t))
+#else
+# define PDC_STAT(field, n)       ((void)0)
+# define PDC_STAT_START(t)
+# define PDC_STAT_TIME(field, t)  ((void)0)
+#endif
+
 /* Internal macros for attributes */
 
 #ifdef CHTYPE_LONG
@@ -13,6 +13,18 @@ void PDC_beep(void)
     PDCINT(0x10, regs);
 }
 
+unsigned long PDC_ms_count(void)
+{
+    /* the BIOS tick count runs at 18.2 Hz */
+
+    return getdosmemdword(0x46c) * 55;
+}
+
+unsigned long PDC_us_count(void)
+{
+    return PDC_ms_count() * 1000UL;
+}
+
 void PDC_napms(int ms)
 {
     PDCREGS regs;
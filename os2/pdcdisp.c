@@ -107,33 +107,44 @@ void _new_packet(attr_t attr, int lineno, int x, int len, const chtype *srcp)
                      (USHORT)x, (PBYTE)&mapped_attr, 0);
 }
 
+/* this port draws each run as it comes; see PDC_transform_line() */
+
+bool PDC_transform_frame(const FRAMERUN *runs, int count, int cury, int curx)
+{
+    PDC_LOG(("PDC_transform_frame() - called: %d runs\n", count));
+
+    return FALSE;
+}
+
+/* this port doesn't move screen contents; doupdate() redraws instead */
+
+bool PDC_scroll_region(int top, int bottom, int n)
+{
+    PDC_LOG(("PDC_scroll_region() - called: top %d bottom %d n %d\n",
+             top, bottom, n));
+
+    return FALSE;
+}
+
 /* update the given physical line to look like the corresponding line in
    curscr */
 
 void PDC_transform_line(int lineno, int x, int len, const chtype *srcp)
 {
-    attr_t old_attr, attr;
-    int i, j;
-
     PDC_LOG(("PDC_transform_line() - called: lineno=%d\n", lineno));
 
-    old_attr = *srcp & (A_ATTRIBUTES ^ A_ALTCHARSET);
+    /* send each run of cells with the same attributes as a packet */
 
-    for (i = 1, j = 1; j < len; i++, j++)
+    while (len > 0)
     {
-        attr = srcp[i] & (A_ATTRIBUTES ^ A_ALTCHARSET);
-
-        if (attr != old_attr)
-        {
-            _new_packet(old_attr, lineno, x, i, srcp);
-            old_attr = attr;
-            srcp += i;
-            x += i;
-            i = 0;
-        }
-    }
+        int run = PDC_attr_run(srcp, len, A_ATTRIBUTES ^ A_ALTCHARSET);
 
-    _new_packet(old_attr, lineno, x, i, srcp);
+        _new_packet(*srcp & (A_ATTRIBUTES ^ A_ALTCHARSET), lineno, x,
+                    run, srcp);
+        srcp += run;
+        x += run;
+        len -= run;
+    }
 }
 
 void PDC_blink_text(void)
@@ -231,8 +231,13 @@ int waddch(WINDOW *win, const chtype ch)
 
         if (win->_y[y][x] != text)
         {
-            if (win->_firstch[y] == _NO_CHANGE)
+            if (win->_spans)
+                PDC_add_span(win, y, x, x);
+            else if (win->_firstch[y] == _NO_CHANGE)
+            {
                 win->_firstch[y] = win->_lastch[y] = x;
+                PDC_SET_DIRTY(win, y);
+            }
             else
                 if (x < win->_firstch[y])
                     win->_firstch[y] = x;
@@ -240,6 +245,9 @@ int waddch(WINDOW *win, const chtype ch)
                     if (x > win->_lastch[y])
                         win->_lastch[y] = x;
 
+            if (!PDC_LINE(win, y))
+                return ERR;
+
             win->_y[y][x] = text;
         }
 
@@ -80,7 +80,12 @@ int waddchnstr(WINDOW *win, const chtype *ch, int n)
 
     x = win->_curx;
     y = win->_cury;
-    ptr = &(win->_y[y][x]);
+    ptr = PDC_LINE(win, y);
+
+    if (!ptr)
+        return ERR;
+
+    ptr += x;
 
     if (n == -1 || n > win->_maxx - x)
         n = win->_maxx - x;
@@ -110,6 +115,9 @@ int waddchnstr(WINDOW *win, const chtype *ch, int n)
     win->_firstch[y] = minx;
     win->_lastch[y] = maxx;
 
+    if (minx != _NO_CHANGE)
+        PDC_SET_DIRTY(win, y);
+
     return OK;
 }
 
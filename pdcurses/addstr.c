@@ -64,8 +64,100 @@ addstr
 
 **man-end****************************************************************/
 
+#include <string.h>
+
+/* In a wide build, the string is decoded a buffer at a time, and the
+   runs are taken from that. */
+
+#ifdef PDC_WIDE
+typedef wchar_t _TEXT;
+# define _CODE(c) ((chtype)(c))
+#else
+typedef char _TEXT;
+# define _CODE(c) ((chtype)(unsigned char)(c))
+#endif
+
+/* Write as much of str as can go straight into the current line: a
+   run of plain characters that doesn't reach the last column, since
+   wrapping is left to waddch(). The attributes are worked out, and
+   the change recorded, once for the run. Returns the number of
+   characters used, 0 if the next one needs waddch(), or -1 on
+   error. */
+
+static int _addrun(WINDOW *win, const _TEXT *str, int n)
+{
+    chtype attr, blank, *line;
+    int x = win->_curx, y = win->_cury;
+    int i, len, first, last, room = win->_maxx - x - 1;
+
+    if (y < 0 || y >= win->_maxy || x < 0 || room < 1)
+        return 0;
+
+    if (n >= 0 && n < room)
+        room = n;
+
+    for (len = 0; len < room; len++)
+    {
+        chtype c = _CODE(str[len]);
+
+        if (!c || (!SP->raw_out && (c < ' ' || c == 0x7f)))
+            break;
+    }
+
+    if (!len)
+        return 0;
+
+    /* as in waddch(), for characters with no attributes of their own */
+
+    attr = win->_attrs;
+
+    if (!(attr & A_COLOR))
+        attr |= win->_bkgd & A_ATTRIBUTES;
+    else
+        attr |= win->_bkgd & (A_ATTRIBUTES ^ A_COLOR);
+
+    blank = (win->_bkgd & A_CHARTEXT) | attr;
+
+#define _CELL(c) ((c) == ' ' ? blank : _CODE(c) | attr)
+
+    line = win->_y[y] + x;
+
+    for (first = 0; first < len; first++)
+        if (line[first] != _CELL(str[first]))
+            break;
+
+    if (first < len)
+    {
+        for (last = len - 1; line[last] == _CELL(str[last]); last--)
+            ;
+
+        line = PDC_LINE(win, y);
+        if (!line)
+            return -1;
+
+        line += x;
+
+        for (i = first; i <= last; i++)
+            line[i] = _CELL(str[i]);
+
+        PDC_add_span(win, y, x + first, x + last);
+    }
+
+#undef _CELL
+
+    win->_curx = x + len;
+
+    PDC_sync(win);
+
+    return len;
+}
+
 int waddnstr(WINDOW *win, const char *str, int n)
 {
+#ifdef PDC_WIDE
+    wchar_t wstr[64];
+    int len, end;
+#endif
     int i = 0;
 
     PDC_LOG(("waddnstr() - called: string=\"%s\" n %d \n", str, n));
@@ -73,22 +165,55 @@ int waddnstr(WINDOW *win, const char *str, int n)
     if (!win || !str)
         return ERR;
 
-    while (str[i] && (i < n || n < 0))
-    {
 #ifdef PDC_WIDE
-        wchar_t wch;
-        int retval = PDC_mbtowc(&wch, str + i, n >= 0 ? n - i : 6);
+    if (n < 0)
+        len = strlen(str);
+    else
+        for (len = 0; len < n && str[len]; len++)
+            ;
 
-        if (retval <= 0)
-            return OK;
+    /* if the string ends before n, the decoder is shown the NUL, so
+       that a sequence cut off by it counts as invalid */
+
+    end = (n < 0 || len < n) ? len + 1 : len;
+
+    while (i < len)
+    {
+        int k = 0, used;
+        int count = PDC_mbsntowcs(wstr, 64, str + i, end - i, &used);
 
-        i += retval;
+        if (!count)
+            break;
+
+        while (k < count)
+        {
+            int run = _addrun(win, wstr + k, count - k);
+
+            if (run < 0)
+                return ERR;
+
+            if (run)
+                k += run;
+            else if (waddch(win, wstr[k++]) == ERR)
+                return ERR;
+        }
+
+        i += used;
+    }
 #else
-        chtype wch = (unsigned char)(str[i++]);
-#endif
-        if (waddch(win, wch) == ERR)
+    while (str[i] && (i < n || n < 0))
+    {
+        int run = _addrun(win, str + i, n >= 0 ? n - i : -1);
+
+        if (run < 0)
+            return ERR;
+
+        if (run)
+            i += run;
+        else if (waddch(win, (unsigned char)(str[i++])) == ERR)
             return ERR;
     }
+#endif
 
     return OK;
 }
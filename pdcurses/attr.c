@@ -305,7 +305,10 @@ int wchgat(WINDOW *win, int n, attr_t attr, short color, const void *opts)
 
     startpos = win->_curx;
     endpos = ((n < 0) ? win->_maxx : min(startpos + n, win->_maxx)) - 1;
-    dest = win->_y[win->_cury];
+    dest = PDC_LINE(win, win->_cury);
+
+    if (!dest)
+        return ERR;
 
     for (n = startpos; n <= endpos; n++)
         dest[n] = (dest[n] & A_CHARTEXT) | newattr;
@@ -318,6 +321,8 @@ int wchgat(WINDOW *win, int n, attr_t attr, short color, const void *opts)
     if (endpos > win->_lastch[n])
         win->_lastch[n] = endpos;
 
+    PDC_SET_DIRTY(win, n);
+
     PDC_sync(win);
 
     return OK;
@@ -65,7 +65,8 @@ int wbkgd(WINDOW *win, chtype ch)
     int x, y;
     chtype oldcolr, oldch, newcolr, newch, colr, attr;
     chtype oldattr = 0, newattr = 0;
-    chtype *winptr;
+    chtype *winptr, *shared;
+    bool seen = FALSE;
 
     PDC_LOG(("wbkgd() - called\n"));
 
@@ -89,11 +90,24 @@ int wbkgd(WINDOW *win, chtype ch)
 
     newch = win->_bkgd & A_CHARTEXT;
 
+    /* the unwritten lines of a paged pad share one line, which is
+       changed only once */
+
+    shared = PDC_blank_line(win);
+
     /* what follows is what seems to occur in the System V
        implementation of this routine */
 
     for (y = 0; y < win->_maxy; y++)
     {
+        if (win->_y[y] == shared)
+        {
+            if (seen)
+                continue;
+
+            seen = TRUE;
+        }
+
         for (x = 0; x < win->_maxx; x++)
         {
             winptr = win->_y[y] + x;
@@ -153,6 +153,10 @@ int wborder(WINDOW *win, chtype ls, chtype rs, chtype ts, chtype bs,
     bl = _attr_passthru(win, bl ? bl : ACS_LLCORNER);
     br = _attr_passthru(win, br ? br : ACS_LRCORNER);
 
+    for (i = 0; i <= ymax; i++)
+        if (!PDC_LINE(win, i))
+            return ERR;
+
     for (i = 1; i < xmax; i++)
     {
         win->_y[0][i] = ts;
@@ -174,6 +178,7 @@ int wborder(WINDOW *win, chtype ls, chtype rs, chtype ts, chtype bs,
     {
         win->_firstch[i] = 0;
         win->_lastch[i] = xmax;
+        PDC_SET_DIRTY(win, i);
     }
 
     PDC_sync(win);
@@ -208,9 +213,12 @@ int whline(WINDOW *win, chtype ch, int n)
 
     startpos = win->_curx;
     endpos = min(startpos + n, win->_maxx) - 1;
-    dest = win->_y[win->_cury];
+    dest = PDC_LINE(win, win->_cury);
     ch = _attr_passthru(win, ch ? ch : ACS_HLINE);
 
+    if (!dest)
+        return ERR;
+
     for (n = startpos; n <= endpos; n++)
         dest[n] = ch;
 
@@ -222,6 +230,8 @@ int whline(WINDOW *win, chtype ch, int n)
     if (endpos > win->_lastch[n])
         win->_lastch[n] = endpos;
 
+    PDC_SET_DIRTY(win, n);
+
     PDC_sync(win);
 
     return OK;
@@ -270,6 +280,9 @@ int wvline(WINDOW *win, chtype ch, int n)
 
     for (n = win->_cury; n < endpos; n++)
     {
+        if (!PDC_LINE(win, n))
+            return ERR;
+
         win->_y[n][x] = ch;
 
         if (x < win->_firstch[n] || win->_firstch[n] == _NO_CHANGE)
@@ -277,6 +290,8 @@ int wvline(WINDOW *win, chtype ch, int n)
 
         if (x > win->_lastch[n])
             win->_lastch[n] = x;
+
+        PDC_SET_DIRTY(win, n);
     }
 
     PDC_sync(win);
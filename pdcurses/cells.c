@@ -0,0 +1,490 @@
+/* Public Domain Curses */
+
+#include <curspriv.h>
+
+/*man-start**************************************************************
+
+cells
+-----
+
+### Synopsis
+
+    int PDC_first_diff(const chtype *a, const chtype *b, int n);
+    int PDC_last_diff(const chtype *a, const chtype *b, int n);
+    int PDC_first_same(const chtype *a, const chtype *b, int n);
+    int PDC_attr_run(const chtype *p, int n, chtype mask);
+    int PDC_ascii_run(const char *s, int n);
+    void PDC_cells_init(void);
+
+### Description
+
+   These are the cell comparison kernels used by the refresh code.
+   Each one compares the n cells at a against the n cells at b.
+
+   PDC_first_diff() returns the index of the first cell that
+   differs, or n if all of them match. PDC_last_diff() returns the
+   index of the last cell that differs, or -1 if all of them match.
+   PDC_first_same() returns the index of the first cell that
+   matches, or n if none of them do.
+
+   PDC_attr_run() is for drawing runs of cells with the same
+   attributes. It returns the number of cells at the start of p
+   (out of n, at most) whose bits in mask match those of p[0]; e.g.,
+   with a mask of A_ATTRIBUTES, the length of the run of cells with
+   the same attributes as the first. It returns 0 if n is 0 or
+   less.
+
+   PDC_ascii_run() is for decoding text. It returns the number of
+   bytes at the start of s (out of n, at most) that are ASCII
+   characters other than NUL. It reads no further than n bytes,
+   even past a NUL.
+
+   When chtypes are 32 bits wide, PDC_cells_init(), called from
+   initscr(), chooses a vectorized version of each: AVX2 or SSE2 on
+   x86, NEON on ARM. Until then, or otherwise, a portable version is
+   used. The results are the same either way.
+
+### Portability
+                             X/Open    BSD    SYS V
+    PDC_first_diff              -       -       -
+    PDC_last_diff               -       -       -
+    PDC_first_same              -       -       -
+    PDC_attr_run                -       -       -
+    PDC_ascii_run               -       -       -
+    PDC_cells_init              -       -       -
+
+**man-end****************************************************************/
+
+#ifdef CHTYPE_LONG
+# if defined(__SSE2__) || defined(_M_X64) || \
+     (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define PDC_CELLS_SSE2
+#  include <emmintrin.h>
+#  if (defined(__GNUC__) || defined(__clang__)) && \
+      (defined(__x86_64__) || defined(__i386__))
+#   define PDC_CELLS_AVX2
+#   include <immintrin.h>
+#  endif
+# elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#  define PDC_CELLS_NEON
+#  include <arm_neon.h>
+# endif
+#endif
+
+typedef int (*_cellfunc)(const chtype *, const chtype *, int);
+typedef int (*_runfunc)(const chtype *, int, chtype);
+typedef int (*_textfunc)(const char *, int);
+
+/* portable versions */
+
+static int _first_diff_c(const chtype *a, const chtype *b, int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++)
+        if (a[i] != b[i])
+            break;
+
+    return i;
+}
+
+static int _last_diff_c(const chtype *a, const chtype *b, int n)
+{
+    int i;
+
+    for (i = n - 1; i >= 0; i--)
+        if (a[i] != b[i])
+            break;
+
+    return i;
+}
+
+static int _first_same_c(const chtype *a, const chtype *b, int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++)
+        if (a[i] == b[i])
+            break;
+
+    return i;
+}
+
+static int _attr_run_c(const chtype *p, int n, chtype mask)
+{
+    int i;
+
+    for (i = 1; i < n; i++)
+        if ((p[i] ^ p[0]) & mask)
+            break;
+
+    return i;
+}
+
+static int _ascii_run_c(const char *s, int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++)
+        if ((unsigned char)(s[i] - 1) >= 0x7f)
+            break;
+
+    return i;
+}
+
+/* The vector versions only locate the block of cells containing the
+   answer; the portable versions above then find it within the block,
+   and also handle any leftover cells at the ends. */
+
+#ifdef PDC_CELLS_SSE2
+
+static int _first_diff_sse2(const chtype *a, const chtype *b, int n)
+{
+    int i;
+
+    for (i = 0; i + 4 <= n; i += 4)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i *)(a + i));
+        __m128i y = _mm_loadu_si128((const __m128i *)(b + i));
+
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(x, y)) != 0xffff)
+            break;
+    }
+
+    return i + _first_diff_c(a + i, b + i, n - i);
+}
+
+static int _last_diff_sse2(const chtype *a, const chtype *b, int n)
+{
+    int i;
+
+    for (i = n; i >= 4; i -= 4)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i *)(a + i - 4));
+        __m128i y = _mm_loadu_si128((const __m128i *)(b + i - 4));
+
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(x, y)) != 0xffff)
+            break;
+    }
+
+    return _last_diff_c(a, b, i);
+}
+
+static int _first_same_sse2(const chtype *a, const chtype *b, int n)
+{
+    int i;
+
+    for (i = 0; i + 4 <= n; i += 4)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i *)(a + i));
+        __m128i y = _mm_loadu_si128((const __m128i *)(b + i));
+
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(x, y)))
+            break;
+    }
+
+    return i + _first_same_c(a + i, b + i, n - i);
+}
+
+static int _attr_run_sse2(const chtype *p, int n, chtype mask)
+{
+    __m128i first = _mm_set1_epi32((int)p[0]);
+    __m128i m = _mm_set1_epi32((int)mask);
+    __m128i zero = _mm_setzero_si128();
+    int i;
+
+    for (i = 0; i + 4 <= n; i += 4)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i *)(p + i));
+
+        x = _mm_and_si128(_mm_xor_si128(x, first), m);
+
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(x, zero)) != 0xffff)
+            break;
+    }
+
+    /* cells before i all match p[0], so p[i - 1] can stand in for it */
+
+    return i ? i - 1 + _attr_run_c(p + i - 1, n - i + 1, mask) :
+               _attr_run_c(p, n, mask);
+}
+
+static int _ascii_run_sse2(const char *s, int n)
+{
+    __m128i zero = _mm_setzero_si128();
+    int i;
+
+    for (i = 0; i + 16 <= n; i += 16)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i *)(s + i));
+
+        /* the high bit is set in non-ASCII bytes */
+
+        if (_mm_movemask_epi8(_mm_or_si128(x, _mm_cmpeq_epi8(x, zero))))
+            break;
+    }
+
+    return i + _ascii_run_c(s + i, n - i);
+}
+
+#endif
+
+#ifdef PDC_CELLS_AVX2
+
+__attribute__((target("avx2")))
+static int _first_diff_avx2(const chtype *a, const chtype *b, int n)
+{
+    int i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(a + i));
+        __m256i y = _mm256_loadu_si256((const __m256i *)(b + i));
+
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(x, y)) != -1)
+            break;
+    }
+
+    return i + _first_diff_sse2(a + i, b + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static int _last_diff_avx2(const chtype *a, const chtype *b, int n)
+{
+    int i;
+
+    for (i = n; i >= 8; i -= 8)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(a + i - 8));
+        __m256i y = _mm256_loadu_si256((const __m256i *)(b + i - 8));
+
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(x, y)) != -1)
+            break;
+    }
+
+    return _last_diff_sse2(a, b, i);
+}
+
+__attribute__((target("avx2")))
+static int _first_same_avx2(const chtype *a, const chtype *b, int n)
+{
+    int i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(a + i));
+        __m256i y = _mm256_loadu_si256((const __m256i *)(b + i));
+
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(x, y)))
+            break;
+    }
+
+    return i + _first_same_sse2(a + i, b + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static int _attr_run_avx2(const chtype *p, int n, chtype mask)
+{
+    __m256i first = _mm256_set1_epi32((int)p[0]);
+    __m256i m = _mm256_set1_epi32((int)mask);
+    __m256i zero = _mm256_setzero_si256();
+    int i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(p + i));
+
+        x = _mm256_and_si256(_mm256_xor_si256(x, first), m);
+
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(x, zero)) != -1)
+            break;
+    }
+
+    return i ? i - 1 + _attr_run_sse2(p + i - 1, n - i + 1, mask) :
+               _attr_run_sse2(p, n, mask);
+}
+
+__attribute__((target("avx2")))
+static int _ascii_run_avx2(const char *s, int n)
+{
+    __m256i zero = _mm256_setzero_si256();
+    int i;
+
+    for (i = 0; i + 32 <= n; i += 32)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(s + i));
+
+        if (_mm256_movemask_epi8(_mm256_or_si256(x,
+                                 _mm256_cmpeq_epi8(x, zero))))
+            break;
+    }
+
+    return i + _ascii_run_sse2(s + i, n - i);
+}
+
+#endif
+
+#ifdef PDC_CELLS_NEON
+
+/* nonzero if all four lanes are set */
+
+static int _all_set(uint32x4_t m)
+{
+# ifdef __aarch64__
+    return vminvq_u32(m) == 0xffffffff;
+# else
+    uint32x2_t t = vand_u32(vget_low_u32(m), vget_high_u32(m));
+
+    return (vget_lane_u32(t, 0) & vget_lane_u32(t, 1)) == 0xffffffff;
+# endif
+}
+
+/* nonzero if any lane is set */
+
+static int _any_set(uint32x4_t m)
+{
+# ifdef __aarch64__
+    return vmaxvq_u32(m) != 0;
+# else
+    uint32x2_t t = vorr_u32(vget_low_u32(m), vget_high_u32(m));
+
+    return (vget_lane_u32(t, 0) | vget_lane_u32(t, 1)) != 0;
+# endif
+}
+
+static int _first_diff_neon(const chtype *a, const chtype *b, int n)
+{
+    const uint32_t *pa = (const uint32_t *)a;
+    const uint32_t *pb = (const uint32_t *)b;
+    int i;
+
+    for (i = 0; i + 4 <= n; i += 4)
+        if (!_all_set(vceqq_u32(vld1q_u32(pa + i), vld1q_u32(pb + i))))
+            break;
+
+    return i + _first_diff_c(a + i, b + i, n - i);
+}
+
+static int _last_diff_neon(const chtype *a, const chtype *b, int n)
+{
+    const uint32_t *pa = (const uint32_t *)a;
+    const uint32_t *pb = (const uint32_t *)b;
+    int i;
+
+    for (i = n; i >= 4; i -= 4)
+        if (!_all_set(vceqq_u32(vld1q_u32(pa + i - 4),
+                                vld1q_u32(pb + i - 4))))
+            break;
+
+    return _last_diff_c(a, b, i);
+}
+
+static int _first_same_neon(const chtype *a, const chtype *b, int n)
+{
+    const uint32_t *pa = (const uint32_t *)a;
+    const uint32_t *pb = (const uint32_t *)b;
+    int i;
+
+    for (i = 0; i + 4 <= n; i += 4)
+        if (_any_set(vceqq_u32(vld1q_u32(pa + i), vld1q_u32(pb + i))))
+            break;
+
+    return i + _first_same_c(a + i, b + i, n - i);
+}
+
+static int _attr_run_neon(const chtype *p, int n, chtype mask)
+{
+    const uint32_t *pp = (const uint32_t *)p;
+    uint32x4_t first = vdupq_n_u32(pp[0]);
+    uint32x4_t m = vdupq_n_u32(mask);
+    int i;
+
+    for (i = 0; i + 4 <= n; i += 4)
+        if (_any_set(vandq_u32(veorq_u32(vld1q_u32(pp + i), first), m)))
+            break;
+
+    return i ? i - 1 + _attr_run_c(p + i - 1, n - i + 1, mask) :
+               _attr_run_c(p, n, mask);
+}
+
+static int _ascii_run_neon(const char *s, int n)
+{
+    const uint8_t *ps = (const uint8_t *)s;
+    uint8x16_t one = vdupq_n_u8(1), last = vdupq_n_u8(0x7e);
+    int i;
+
+    /* bytes from 1 to 0x7f become 0 to 0x7e; others wrap past that */
+
+    for (i = 0; i + 16 <= n; i += 16)
+        if (!_all_set(vreinterpretq_u32_u8(vcleq_u8(vsubq_u8(
+                vld1q_u8(ps + i), one), last))))
+            break;
+
+    return i + _ascii_run_c(s + i, n - i);
+}
+
+#endif
+
+/* The kernels start out as the portable versions, so they work even
+   before initscr(); PDC_cells_init() then picks the best versions for
+   this CPU, once, before the port can start any threads. */
+
+static _cellfunc _first_diff = _first_diff_c;
+static _cellfunc _last_diff = _last_diff_c;
+static _cellfunc _first_same = _first_same_c;
+static _runfunc _attr_run = _attr_run_c;
+static _textfunc _ascii_run = _ascii_run_c;
+
+void PDC_cells_init(void)
+{
+#if defined(PDC_CELLS_NEON)
+    _first_diff = _first_diff_neon;
+    _last_diff = _last_diff_neon;
+    _first_same = _first_same_neon;
+    _attr_run = _attr_run_neon;
+    _ascii_run = _ascii_run_neon;
+#elif defined(PDC_CELLS_SSE2)
+    _first_diff = _first_diff_sse2;
+    _last_diff = _last_diff_sse2;
+    _first_same = _first_same_sse2;
+    _attr_run = _attr_run_sse2;
+    _ascii_run = _ascii_run_sse2;
+# ifdef PDC_CELLS_AVX2
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2"))
+    {
+        _first_diff = _first_diff_avx2;
+        _last_diff = _last_diff_avx2;
+        _first_same = _first_same_avx2;
+        _attr_run = _attr_run_avx2;
+        _ascii_run = _ascii_run_avx2;
+    }
+# endif
+#endif
+}
+
+int PDC_first_diff(const chtype *a, const chtype *b, int n)
+{
+    return _first_diff(a, b, n);
+}
+
+int PDC_last_diff(const chtype *a, const chtype *b, int n)
+{
+    return _last_diff(a, b, n);
+}
+
+int PDC_first_same(const chtype *a, const chtype *b, int n)
+{
+    return _first_same(a, b, n);
+}
+
+int PDC_attr_run(const chtype *p, int n, chtype mask)
+{
+    return (n > 0) ? _attr_run(p, n, mask) : 0;
+}
+
+int PDC_ascii_run(const char *s, int n)
+{
+    return (n > 0) ? _ascii_run(s, n) : 0;
+}
@@ -68,13 +68,20 @@ int wclrtoeol(WINDOW *win)
 
     blank = win->_bkgd;
 
-    for (minx = x, ptr = &win->_y[y][x]; minx < win->_maxx; minx++, ptr++)
-        *ptr = blank;
+    /* a paged pad's line may just go back to being blank */
 
-    if (x < win->_firstch[y] || win->_firstch[y] == _NO_CHANGE)
-        win->_firstch[y] = x;
+    if (x || !PDC_page_clear(win, y, blank))
+    {
+        ptr = PDC_LINE(win, y);
+
+        if (!ptr)
+            return ERR;
+
+        for (minx = x, ptr += x; minx < win->_maxx; minx++, ptr++)
+            *ptr = blank;
+    }
 
-    win->_lastch[y] = win->_maxx - 1;
+    PDC_add_span(win, y, x, win->_maxx - 1);
 
     PDC_sync(win);
     return OK;
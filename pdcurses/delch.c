@@ -50,7 +50,12 @@ int wdelch(WINDOW *win)
     y = win->_cury;
     x = win->_curx;
     maxx = win->_maxx - 1;
-    temp1 = &win->_y[y][x];
+    temp1 = PDC_LINE(win, y);
+
+    if (!temp1)
+        return ERR;
+
+    temp1 += x;
 
     memmove(temp1, temp1 + 1, (maxx - x) * sizeof(chtype));
 
@@ -63,6 +68,8 @@ int wdelch(WINDOW *win)
     if ((win->_firstch[y] == _NO_CHANGE) || (win->_firstch[y] > x))
         win->_firstch[y] = x;
 
+    PDC_SET_DIRTY(win, y);
+
     PDC_sync(win);
 
     return OK;
@@ -56,34 +56,29 @@ deleteln
 int wdeleteln(WINDOW *win)
 {
     chtype blank, *temp, *ptr;
-    int y;
 
     PDC_LOG(("wdeleteln() - called\n"));
 
     if (!win)
         return ERR;
 
+    if (win->_cury <= win->_bmarg)
+        return PDC_shift_lines(win, win->_cury, win->_bmarg, 1);
+
+    /* below the scrolling region, the line is only cleared */
+
     /* wrs (4/10/93) account for window background */
 
     blank = win->_bkgd;
 
-    temp = win->_y[win->_cury];
-
-    for (y = win->_cury; y < win->_bmarg; y++)
+    if (!PDC_page_clear(win, win->_cury, blank))
     {
-        win->_y[y] = win->_y[y + 1];
-        win->_firstch[y] = 0;
-        win->_lastch[y] = win->_maxx - 1;
-    }
-
-    for (ptr = temp; (ptr - temp < win->_maxx); ptr++)
-        *ptr = blank;           /* make a blank line */
+        temp = PDC_LINE(win, win->_cury);
+        if (!temp)
+            return ERR;
 
-    if (win->_cury <= win->_bmarg)
-    {
-        win->_firstch[win->_bmarg] = 0;
-        win->_lastch[win->_bmarg] = win->_maxx - 1;
-        win->_y[win->_bmarg] = temp;
+        for (ptr = temp; (ptr - temp < win->_maxx); ptr++)
+            *ptr = blank;           /* make a blank line */
     }
 
     return OK;
@@ -118,28 +113,22 @@ int mvwdeleteln(WINDOW *win, int y, int x)
 
 int winsdelln(WINDOW *win, int n)
 {
-    int i;
-
     PDC_LOG(("winsdelln() - called\n"));
 
     if (!win)
         return ERR;
 
+    /* as with repeated calls to winsertln() or wdeleteln(), lines are
+       inserted down to the bottom of the window, but deleted only up
+       to the bottom margin */
+
     if (n > 0)
-    {
-        for (i = 0; i < n; i++)
-            if (winsertln(win) == ERR)
-                return ERR;
-    }
-    else if (n < 0)
-    {
-        n = -n;
-        for (i = 0; i < n; i++)
-            if (wdeleteln(win) == ERR)
-                return ERR;
-    }
+        return PDC_shift_lines(win, win->_cury, win->_maxy - 1, -n);
 
-    return OK;
+    if (n < 0 && win->_cury <= win->_bmarg)
+        return PDC_shift_lines(win, win->_cury, win->_bmarg, -n);
+
+    return n ? wdeleteln(win) : OK;
 }
 
 int insdelln(int n)
@@ -151,36 +140,12 @@ int insdelln(int n)
 
 int winsertln(WINDOW *win)
 {
-    chtype blank, *temp, *end;
-    int y;
-
     PDC_LOG(("winsertln() - called\n"));
 
     if (!win)
         return ERR;
 
-    /* wrs (4/10/93) account for window background */
-
-    blank = win->_bkgd;
-
-    temp = win->_y[win->_maxy - 1];
-
-    for (y = win->_maxy - 1; y > win->_cury; y--)
-    {
-        win->_y[y] = win->_y[y - 1];
-        win->_firstch[y] = 0;
-        win->_lastch[y] = win->_maxx - 1;
-    }
-
-    win->_y[win->_cury] = temp;
-
-    for (end = &temp[win->_maxx - 1]; temp <= end; temp++)
-        *temp = blank;
-
-    win->_firstch[win->_cury] = 0;
-    win->_lastch[win->_cury] = win->_maxx - 1;
-
-    return OK;
+    return PDC_shift_lines(win, win->_cury, win->_maxy - 1, -1);
 }
 
 int insertln(void)
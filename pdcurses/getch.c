@@ -192,6 +192,12 @@ int wgetch(WINDOW *win)
           win->_begy + win->_cury != SP->cursrow)) || is_wintouched(win)))
         wrefresh(win);
 
+    /* an update put off by PDC_set_max_fps() is drawn as soon as it's
+       due, whichever way wgetch() returns; a polling loop gets there
+       by calling again */
+
+    PDC_refresh_pending();
+
     /* if ungotten char exists, remove and return it */
 
     if (c_ungind)
@@ -120,6 +120,8 @@ WINDOW *Xinitscr(int argc, char *argv[])
     if (SP && SP->alive)
         return NULL;
 
+    PDC_cells_init();
+
     if (PDC_scr_open(argc, argv) == ERR)
     {
         fprintf(stderr, "initscr(): Unable to create SP\n");
@@ -240,6 +242,8 @@ int endwin(void)
 {
     PDC_LOG(("endwin() - called\n"));
 
+    PDC_refresh_flush();
+
     /* Allow temporary exit from curses using endwin() */
 
     def_prog_mode();
@@ -281,6 +285,8 @@ void delscreen(SCREEN *sp)
         return;
 
     PDC_slk_free();     /* free the soft label keys, if needed */
+    PDC_refresh_free(); /* free doupdate()'s buffers */
+    PDC_printw_free();  /* and printw()'s */
 
     delwin(stdscr);
     delwin(curscr);
@@ -300,13 +306,21 @@ int resize_term(int nlines, int ncols)
 {
     PDC_LOG(("resize_term() - called: nlines %d\n", nlines));
 
-    if (!stdscr || PDC_resize_screen(nlines, ncols) == ERR)
+    if (!stdscr)
+        return ERR;
+
+    PDC_sync_lastscr();
+
+    if (PDC_resize_screen(nlines, ncols) == ERR)
         return ERR;
 
     SP->lines = PDC_get_rows();
     LINES = SP->lines - SP->linesrippedoff - SP->slklines;
     SP->cols = COLS = PDC_get_columns();
 
+    /* wresize() gives curscr and pdc_lastscr back any lines that
+       doupdate() traded between them, before either is freed */
+
     if (wresize(curscr, SP->lines, SP->cols) == ERR ||
         wresize(stdscr, LINES, COLS) == ERR ||
         wresize(pdc_lastscr, SP->lines, SP->cols) == ERR)
@@ -151,7 +151,12 @@ int winsch(WINDOW *win, chtype ch)
         ch |= attr;
 
         maxx = win->_maxx;
-        temp = &win->_y[y][x];
+        temp = PDC_LINE(win, y);
+
+        if (!temp)
+            return ERR;
+
+        temp += x;
 
         memmove(temp + 1, temp, (maxx - x - 1) * sizeof(chtype));
 
@@ -160,6 +165,8 @@ int winsch(WINDOW *win, chtype ch)
         if ((win->_firstch[y] == _NO_CHANGE) || (win->_firstch[y] > x))
             win->_firstch[y] = x;
 
+        PDC_SET_DIRTY(win, y);
+
         *temp = ch;
     }
 
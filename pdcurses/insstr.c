@@ -71,8 +71,7 @@ insstr
 int winsnstr(WINDOW *win, const char *str, int n)
 {
 #ifdef PDC_WIDE
-    wchar_t wstr[513], *p;
-    int i;
+    wchar_t wstr[512], *p;
 #endif
     int len;
 
@@ -87,21 +86,12 @@ int winsnstr(WINDOW *win, const char *str, int n)
         n = len;
 
 #ifdef PDC_WIDE
-    if (n > 512)
-        n = 512;
+    /* n is never less than len here; the decoder reads whole blocks,
+       so it's only given the string and its NUL, which stops it */
 
-    p = wstr;
-    i = 0;
+    n = (len < 512) ? len + 1 : 512;
 
-    while (str[i] && i < n)
-    {
-        int retval = PDC_mbtowc(p, str + i, n - i);
-
-        if (retval <= 0)
-            break;
-        p++;
-        i += retval;
-    }
+    p = wstr + PDC_mbsntowcs(wstr, 512, str, n, NULL);
 
     while (p > wstr)
         if (winsch(win, *--p) == ERR)
@@ -209,6 +209,8 @@ int napms(int ms)
 {
     PDC_LOG(("napms() - called: ms=%d\n", ms));
 
+    PDC_refresh_flush();
+
     if (ms)
         PDC_napms(ms);
 
@@ -15,6 +15,11 @@ overlay
                 int src_tc, int dst_tr, int dst_tc, int dst_br,
                 int dst_bc, int _overlay)
 
+    int PDC_blit(WINDOW *win, int y, int x, const chtype *cells,
+                 int nrows, int ncols, int stride);
+    int PDC_blit_key(WINDOW *win, int y, int x, const chtype *cells,
+                     int nrows, int ncols, int stride, chtype key);
+
 ### Description
 
    overlay() and overwrite() copy all the text from src_w into
@@ -34,18 +39,35 @@ overlay
    window are not copied to the destination window. When overlay is
    FALSE, blanks are copied.
 
+   PDC_blit() copies a matrix of cells from the application's own
+   memory into win, with its top left corner at (y, x). The matrix
+   has nrows rows of ncols chtypes, each row starting stride cells
+   after the one before. Whatever falls outside the window, on any
+   side, is left out. Each row is compared with the window first;
+   only the part that differs is copied, with one memcpy(), and
+   recorded as changed. PDC_blit_key() is the same, except that
+   cells equal to key are transparent, and leave the window as it
+   was. Neither moves the cursor, or applies the window's
+   attributes or background; the cells are copied as they are.
+
 ### Return Value
 
-   All functions return OK on success and ERR on error.
+   All functions return OK on success and ERR on error. PDC_blit()
+   and PDC_blit_key() return ERR if stride is less than ncols, or
+   win is curscr.
 
 ### Portability
                              X/Open    BSD    SYS V
     overlay                     Y       Y       Y
     overwrite                   Y       Y       Y
     copywin                     Y       -      3.0
+    PDC_blit                    -       -       -
+    PDC_blit_key                -       -       -
 
 **man-end****************************************************************/
 
+#include <string.h>
+
 /* Thanks to Andreas Otte <venn@@uni-paderborn.de> for the
    corrected overlay()/overwrite() behavior. */
 
@@ -53,8 +75,9 @@ static int _copy_win(const WINDOW *src_w, WINDOW *dst_w, int src_tr,
                      int src_tc, int src_br, int src_bc, int dst_tr,
                      int dst_tc, bool _overlay)
 {
-    int col, line, y1, fc, *minchng, *maxchng;
+    int col, line, y1, fc, rc, *minchng, *maxchng;
     chtype *w1ptr, *w2ptr;
+    bool owned;
 
     int lc = 0;
     int xdiff = src_bc - src_tc;
@@ -63,6 +86,9 @@ static int _copy_win(const WINDOW *src_w, WINDOW *dst_w, int src_tr,
     if (!src_w || !dst_w)
         return ERR;
 
+    if (dst_w == curscr)
+        PDC_sync_lastscr();
+
     minchng = dst_w->_firstch;
     maxchng = dst_w->_lastch;
 
@@ -77,26 +103,57 @@ static int _copy_win(const WINDOW *src_w, WINDOW *dst_w, int src_tr,
         w1ptr = src_w->_y[line + src_tr] + src_tc;
         w2ptr = dst_w->_y[line + dst_tr] + dst_tc;
 
-        fc = _NO_CHANGE;
+        /* a line of a paged pad gets storage of its own only when
+           something's actually written to it */
+
+        owned = !(dst_w->_flags & _PAGED);
+
+        fc = rc = _NO_CHANGE;
 
         for (col = 0; col < xdiff; col++)
         {
             if ((*w1ptr) != (*w2ptr) &&
                 !((*w1ptr & A_CHARTEXT) == ' ' && _overlay))
             {
+                if (!owned)
+                {
+                    w2ptr = PDC_LINE(dst_w, line + dst_tr);
+
+                    if (!w2ptr)
+                        return ERR;
+
+                    w2ptr += dst_tc + col;
+                    owned = TRUE;
+                }
+
                 *w2ptr = *w1ptr;
 
                 if (fc == _NO_CHANGE)
                     fc = col + dst_tc;
 
+                if (rc == _NO_CHANGE)
+                    rc = col + dst_tc;
+
                 lc = col + dst_tc;
             }
+            else if (rc != _NO_CHANGE && dst_w->_spans)
+            {
+                /* record each run of changes separately */
+
+                PDC_add_span(dst_w, line + dst_tr, rc, lc);
+                rc = _NO_CHANGE;
+            }
 
             w1ptr++;
             w2ptr++;
         }
 
-        if (*minchng == _NO_CHANGE)
+        if (dst_w->_spans)
+        {
+            if (rc != _NO_CHANGE)
+                PDC_add_span(dst_w, line + dst_tr, rc, lc);
+        }
+        else if (*minchng == _NO_CHANGE)
         {
             *minchng = fc;
             *maxchng = lc;
@@ -109,6 +166,9 @@ static int _copy_win(const WINDOW *src_w, WINDOW *dst_w, int src_tr,
                 *maxchng = lc;
         }
 
+        if (fc != _NO_CHANGE && !dst_w->_spans)
+            PDC_SET_DIRTY(dst_w, line + dst_tr);
+
         minchng++;
         maxchng++;
     }
@@ -212,3 +272,104 @@ int copywin(const WINDOW *src_w, WINDOW *dst_w, int src_tr, int src_tc,
     return _copy_win(src_w, dst_w, src_tr, src_tc, src_end_y, src_end_x,
                      dst_tr, dst_tc, _overlay);
 }
+
+static int _blit(WINDOW *win, int y, int x, const chtype *cells,
+                 int nrows, int ncols, int stride, bool keyed, chtype key)
+{
+    int i, first, last, ncopy;
+
+    if (!win || !cells || win == curscr || stride < ncols)
+        return ERR;
+
+    /* clip to the window */
+
+    if (y < 0)
+    {
+        cells -= (long)y * stride;
+        nrows += y;
+        y = 0;
+    }
+
+    if (x < 0)
+    {
+        cells -= x;
+        ncols += x;
+        x = 0;
+    }
+
+    nrows = min(nrows, win->_maxy - y);
+    ncopy = min(ncols, win->_maxx - x);
+
+    for (i = 0; i < nrows && ncopy > 0; i++, cells += stride)
+    {
+        chtype *dest = win->_y[y + i] + x;
+
+        if (keyed)
+        {
+            int j;
+
+            /* find the first and last cells that would change */
+
+            for (first = 0; first < ncopy; first++)
+                if (cells[first] != key && cells[first] != dest[first])
+                    break;
+
+            if (first == ncopy)
+                continue;
+
+            for (last = ncopy - 1; last > first; last--)
+                if (cells[last] != key && cells[last] != dest[last])
+                    break;
+
+            dest = PDC_LINE(win, y + i);
+            if (!dest)
+                return ERR;
+
+            dest += x;
+
+            for (j = first; j <= last; j++)
+                if (cells[j] != key)
+                    dest[j] = cells[j];
+        }
+        else
+        {
+            first = PDC_first_diff(cells, dest, ncopy);
+
+            if (first == ncopy)
+                continue;
+
+            last = first + PDC_last_diff(cells + first, dest + first,
+                                         ncopy - first);
+
+            dest = PDC_LINE(win, y + i);
+            if (!dest)
+                return ERR;
+
+            memcpy(dest + x + first, cells + first,
+                   (last - first + 1) * sizeof(chtype));
+        }
+
+        PDC_add_span(win, y + i, x + first, x + last);
+    }
+
+    PDC_sync(win);
+    return OK;
+}
+
+int PDC_blit(WINDOW *win, int y, int x, const chtype *cells,
+             int nrows, int ncols, int stride)
+{
+    PDC_LOG(("PDC_blit() - called: y %d x %d rows %d cols %d\n",
+             y, x, nrows, ncols));
+
+    return _blit(win, y, x, cells, nrows, ncols, stride, FALSE, 0);
+}
+
+int PDC_blit_key(WINDOW *win, int y, int x, const chtype *cells,
+                 int nrows, int ncols, int stride, chtype key)
+{
+    PDC_LOG(("PDC_blit_key() - called: y %d x %d rows %d cols %d\n",
+             y, x, nrows, ncols));
+
+    return _blit(win, y, x, cells, nrows, ncols, stride, TRUE, key);
+}
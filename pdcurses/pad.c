@@ -18,6 +18,8 @@ pad
                      int sy2, int sx2);
     int pechochar(WINDOW *pad, chtype ch);
     int pecho_wchar(WINDOW *pad, const cchar_t *wch);
+    int PDC_set_paged_pads(bool on);
+    WINDOW *PDC_map_pad(const char *filename, int nlines, int ncols);
 
 ### Description
 
@@ -54,9 +56,35 @@ pad
    a call to prefresh(), with the last-used coordinates and
    dimensions. pecho_wchar() is the wide-character version.
 
+   PDC_set_paged_pads() turns on (or off) paged storage for pads
+   created afterwards by newpad(). A paged pad allocates memory only
+   for lines that have been written to, in pages of 64 lines; the
+   others share a single blank line. A line that's cleared to the
+   background (by werase(), wclrtobot(), wclrtoeol() from the first
+   column, or scrolling) gives its memory back, and a page is freed
+   when all of its lines are. This suits a very large pad, e.g. for
+   a log, that's mostly empty. Paged pads can't have sub-pads;
+   dupwin() and wresize() give paged pads.
+
+   PDC_map_pad() creates a pad whose lines are kept in a file, which
+   is mapped into memory, so that the system reads in only the parts
+   that are displayed, and writes back the ones that are changed.
+   Given a size, it creates the file (replacing any existing one),
+   and fills it with blanks; with nlines and ncols both 0, it opens
+   an existing file, and takes the size from it, without reading
+   the rest. The file has the same format as one written by
+   putwin(): "PDC" and a version byte, then the WINDOW structure,
+   then the lines, in order, each of ncols chtypes in native byte
+   order. The WINDOW structure is updated by delwin(), which also
+   unmaps the file. A mapped pad can't be resized, and dupwin() of
+   one gives an ordinary pad. It's only available where the system
+   has mmap().
+
 ### Return Value
 
-   All functions return OK on success and ERR on error.
+   newpad(), subpad() and PDC_map_pad() return a pointer to the new
+   pad, or NULL on failure. Other functions return OK on success
+   and ERR on error.
 
 ### Portability
                              X/Open    BSD    SYS V
@@ -66,11 +94,27 @@ pad
     pnoutrefresh                Y       -       Y
     pechochar                   Y       -      3.0
     pecho_wchar                 Y
+    PDC_set_paged_pads          -       -       -
+    PDC_map_pad                 -       -       -
 
 **man-end****************************************************************/
 
 #include <string.h>
 
+#ifdef HAVE_MMAP
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+/* a mapped pad's file starts with the marker and version, and the
+   WINDOW struct, as from putwin(), and its lines follow */
+
+#define _MAP_HEAD (4 + sizeof(WINDOW))
+
+static bool _paged_pads = FALSE;
+
 /* save values for pechochar() */
 
 static int save_pminrow, save_pmincol;
@@ -84,14 +128,14 @@ WINDOW *newpad(int nlines, int ncols)
 
     win = PDC_makenew(nlines, ncols, 0, 0);
     if (win)
-        win = PDC_makelines(win);
+        win = _paged_pads ? PDC_makepages(win) : PDC_makelines(win);
 
     if (!win)
         return (WINDOW *)NULL;
 
     werase(win);
 
-    win->_flags = _PAD;
+    win->_flags |= _PAD;
 
     /* save default values in case pechochar() is the first call to
        prefresh(). */
@@ -106,6 +150,140 @@ WINDOW *newpad(int nlines, int ncols)
     return win;
 }
 
+#ifdef HAVE_MMAP
+static size_t _map_size(int nlines, int ncols)
+{
+    return _MAP_HEAD + (size_t)nlines * ncols * sizeof(chtype);
+}
+
+/* open an existing pad file, and read its WINDOW struct into saved;
+   returns the descriptor, or -1 */
+
+static int _map_open(const char *filename, WINDOW *saved)
+{
+    struct stat st;
+    char marker[4];
+    int fd;
+
+    fd = open(filename, O_RDWR);
+    if (fd == -1)
+        return -1;
+
+    if (read(fd, marker, 4) != 4 || strncmp(marker, "PDC", 3)
+        || marker[3] != PDC_DUMPVER
+        || read(fd, saved, sizeof(WINDOW)) != sizeof(WINDOW)
+        || saved->_maxy < 1 || saved->_maxx < 1 || fstat(fd, &st) == -1
+        || (size_t)st.st_size < _map_size(saved->_maxy, saved->_maxx))
+    {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+#endif
+
+WINDOW *PDC_map_pad(const char *filename, int nlines, int ncols)
+{
+#ifdef HAVE_MMAP
+    WINDOW *win, saved;
+    char *map;
+    size_t size;
+    bool create = (nlines != 0);
+    int fd, i;
+
+    PDC_LOG(("PDC_map_pad() - called: file %s lines %d cols %d\n",
+             filename ? filename : "(null)", nlines, ncols));
+
+    if (!filename || nlines < 0 || ncols < 0 || (ncols != 0) != create)
+        return (WINDOW *)NULL;
+
+    if (create)
+    {
+        fd = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0666);
+        if (fd == -1)
+            return (WINDOW *)NULL;
+
+        if (ftruncate(fd, _map_size(nlines, ncols)) == -1)
+        {
+            close(fd);
+            return (WINDOW *)NULL;
+        }
+    }
+    else
+    {
+        fd = _map_open(filename, &saved);
+        if (fd == -1)
+            return (WINDOW *)NULL;
+
+        nlines = saved._maxy;
+        ncols = saved._maxx;
+    }
+
+    size = _map_size(nlines, ncols);
+
+    map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (map == MAP_FAILED)
+        return (WINDOW *)NULL;
+
+    win = PDC_makenew(nlines, ncols, 0, 0);
+    if (!win)
+    {
+        munmap(map, size);
+        return (WINDOW *)NULL;
+    }
+
+    for (i = 0; i < nlines; i++)
+        win->_y[i] = (chtype *)(map + _MAP_HEAD) + (size_t)i * ncols;
+
+    win->_flags = _PAD | _MAPPED;
+
+    if (create)
+    {
+        memcpy(map, "PDC", 3);
+        map[3] = PDC_DUMPVER;
+
+        werase(win);
+    }
+    else
+    {
+        win->_bkgd = saved._bkgd;
+        win->_attrs = saved._attrs;
+        win->_cury = saved._cury;
+        win->_curx = saved._curx;
+        win->_scroll = saved._scroll;
+    }
+
+    memcpy(map + 4, win, sizeof(WINDOW));
+
+    save_pminrow = 0;
+    save_pmincol = 0;
+    save_sminrow = 0;
+    save_smincol = 0;
+    save_smaxrow = min(LINES, nlines) - 1;
+    save_smaxcol = min(COLS, ncols) - 1;
+
+    return win;
+#else
+    return (WINDOW *)NULL;
+#endif
+}
+
+void PDC_unmap_pad(WINDOW *win)
+{
+#ifdef HAVE_MMAP
+    /* the lines are never rearranged, so the first one still follows
+       the header */
+
+    char *map = (char *)win->_y[0] - _MAP_HEAD;
+
+    memcpy(map + 4, win, sizeof(WINDOW));
+    munmap(map, _map_size(win->_maxy, win->_maxx));
+#endif
+}
+
 WINDOW *subpad(WINDOW *orig, int nlines, int ncols, int begy, int begx)
 {
     WINDOW *win;
@@ -114,7 +292,7 @@ WINDOW *subpad(WINDOW *orig, int nlines, int ncols, int begy, int begx)
     PDC_LOG(("subpad() - called: lines=%d cols=%d begy=%d begx=%d\n",
              nlines, ncols, begy, begx));
 
-    if (!orig || !(orig->_flags & _PAD))
+    if (!orig || !(orig->_flags & _PAD) || (orig->_flags & _PAGED))
         return (WINDOW *)NULL;
 
     /* make sure window fits inside the original one */
@@ -177,6 +355,7 @@ int pnoutrefresh(WINDOW *w, int py, int px, int sy1, int sx1, int sy2, int sx2)
     int num_cols;
     int sline = sy1;
     int pline = py;
+    PDC_STAT_START(start);
 
     PDC_LOG(("pnoutrefresh() - called\n"));
 
@@ -197,6 +376,8 @@ int pnoutrefresh(WINDOW *w, int py, int px, int sy1, int sx1, int sy2, int sx2)
 
     num_cols = min((sx2 - sx1 + 1), (w->_maxx - px));
 
+    PDC_sync_lastscr();
+
     while (sline <= sy2)
     {
         if (pline < w->_maxy)
@@ -204,12 +385,9 @@ int pnoutrefresh(WINDOW *w, int py, int px, int sy1, int sx1, int sy2, int sx2)
             memcpy(curscr->_y[sline] + sx1, w->_y[pline] + px,
                    num_cols * sizeof(chtype));
 
-            if ((curscr->_firstch[sline] == _NO_CHANGE)
-                || (curscr->_firstch[sline] > sx1))
-                curscr->_firstch[sline] = sx1;
+            PDC_STAT(copied, num_cols * sizeof(chtype));
 
-            if (sx2 > curscr->_lastch[sline])
-                curscr->_lastch[sline] = sx2;
+            PDC_add_span(curscr, sline, sx1, sx2);
 
             w->_firstch[pline] = _NO_CHANGE; /* updated now */
             w->_lastch[pline] = _NO_CHANGE;  /* updated now */
@@ -236,6 +414,8 @@ int pnoutrefresh(WINDOW *w, int py, int px, int sy1, int sx1, int sy2, int sx2)
         curscr->_curx = (w->_curx - px) + sx1;
     }
 
+    PDC_STAT_TIME(refresh_us, start);
+
     return OK;
 }
 
@@ -262,3 +442,12 @@ int pecho_wchar(WINDOW *pad, const cchar_t *wch)
                     save_smincol, save_smaxrow, save_smaxcol);
 }
 #endif
+
+int PDC_set_paged_pads(bool on)
+{
+    PDC_LOG(("PDC_set_paged_pads() - called: on %d\n", on));
+
+    _paged_pads = on;
+
+    return OK;
+}
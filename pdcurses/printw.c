@@ -23,6 +23,12 @@ printw
    the same as used in the standard C library's printf(). (printw()
    can be used as a drop-in replacement for printf().)
 
+   Where vsnprintf() is available, there's no limit on the length of
+   the output. Output too long for a buffer on the stack is formatted
+   into one that's kept for later calls, and only reallocated when
+   something longer comes along; it's freed by delscreen(). Without
+   vsnprintf(), output is limited to 512 bytes.
+
 ### Return Value
 
    All functions return the number of characters printed, or
@@ -39,21 +45,99 @@ printw
 
 **man-end****************************************************************/
 
+#include <limits.h>
+#include <stdlib.h>
 #include <string.h>
 
+#ifdef HAVE_VSNPRINTF
+# ifndef va_copy
+#  ifdef __va_copy
+#   define va_copy(d, s) __va_copy(d, s)
+#  else
+#   define va_copy(d, s) memcpy(&(d), &(s), sizeof(va_list))
+#  endif
+# endif
+
+/* the most the buffer is doubled to when vsnprintf() gives -1 */
+
+# define _PRINTMAX 65536
+
+static char *_printbuf = NULL;
+static size_t _printsize = 0;
+#endif
+
+void PDC_printw_free(void)
+{
+#ifdef HAVE_VSNPRINTF
+    free(_printbuf);
+
+    _printbuf = NULL;
+    _printsize = 0;
+#endif
+}
+
 int vwprintw(WINDOW *win, const char *fmt, va_list varglist)
 {
-    char printbuf[513];
+    char printbuf[513], *buf = printbuf;
     int len;
+#ifdef HAVE_VSNPRINTF
+    size_t size = sizeof(printbuf);
 
     PDC_LOG(("vwprintw() - called\n"));
 
-#ifdef HAVE_VSNPRINTF
-    len = vsnprintf(printbuf, 512, fmt, varglist);
+    /* once there's a kept buffer, it's used from the start */
+
+    if (_printbuf)
+    {
+        buf = _printbuf;
+        size = _printsize;
+    }
+
+    for (;;)
+    {
+        va_list args;
+
+        va_copy(args, varglist);
+        len = vsnprintf(buf, size, fmt, args);
+        va_end(args);
+
+        if (len >= 0 && (size_t)len < size)
+            break;
+
+        /* too long: len is the length needed, or -1 from some older
+           libraries, in which case the buffer is doubled, up to a
+           point; -1 can also mean an error that no size will cure */
+
+        if (len < 0)
+        {
+            if (size >= _PRINTMAX)
+                return ERR;
+
+            size *= 2;
+        }
+        else
+            size = (size_t)len + 1;
+
+        if (size > _printsize)
+        {
+            char *p = (size <= INT_MAX) ? realloc(_printbuf, size) : NULL;
+
+            if (!p)
+                return ERR;
+
+            _printbuf = p;
+            _printsize = size;
+        }
+
+        buf = _printbuf;
+        size = _printsize;
+    }
 #else
+    PDC_LOG(("vwprintw() - called\n"));
+
     len = vsprintf(printbuf, fmt, varglist);
 #endif
-    return (waddstr(win, printbuf) == ERR) ? ERR : len;
+    return (waddnstr(win, buf, len) == ERR) ? ERR : len;
 }
 
 int printw(const char *fmt, ...)
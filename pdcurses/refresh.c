@@ -15,6 +15,10 @@ refresh
     int doupdate(void);
     int redrawwin(WINDOW *win);
     int wredrawln(WINDOW *win, int beg_line, int num_lines);
+    int PDC_set_max_fps(int fps);
+    int PDC_get_refresh_stats(PDC_REFRESH_STATS *total,
+                              PDC_REFRESH_STATS *last);
+    int PDC_reset_refresh_stats(void);
 
 ### Description
 
@@ -42,9 +46,30 @@ refresh
    implementations, there's a subtle distinction, but it has no
    meaning in PDCurses.
 
+   PDC_set_max_fps() limits how often doupdate() redraws the screen
+   to fps times per second, for programs that refresh after every
+   small change. When called too soon after the last redraw,
+   doupdate() only leaves its changes pending in curscr; they're
+   drawn by the next doupdate() or wgetch() that comes late enough,
+   or by napms() (and so by a wgetch() that waits for input), or
+   endwin(), whichever comes first. Zero, the default, removes the
+   limit.
+
+   PDC_get_refresh_stats() reports how much work the refresh code has
+   done: in total into *total, and for the last frame drawn by
+   doupdate() (including the wnoutrefresh() calls leading up to it)
+   into *last. Either pointer may be NULL. The times are in
+   microseconds of elapsed time, as the platform's clock measures it;
+   doupdate()'s includes that spent in the platform layer, waiting on
+   it included. PDC_reset_refresh_stats() sets all the
+   counts back to zero. The counts are only kept if PDCurses was
+   built with PDC_STATS defined.
+
 ### Return Value
 
    All functions return OK on success and ERR on error.
+   PDC_get_refresh_stats() and PDC_reset_refresh_stats() return ERR
+   if PDCurses was built without PDC_STATS.
 
 ### Portability
                              X/Open    BSD    SYS V
@@ -54,15 +79,163 @@ refresh
     doupdate                    Y       Y       Y
     redrawwin                   Y       -      4.0
     wredrawln                   Y       -      4.0
+    PDC_set_max_fps             -       -       -
+    PDC_get_refresh_stats       -       -       -
+    PDC_reset_refresh_stats     -       -       -
 
 **man-end****************************************************************/
 
+#include <stdlib.h>
 #include <string.h>
 
+/* After an update, the copy of each changed range from curscr to
+   pdc_lastscr is put off. If the next change to that line of curscr
+   replaces all of it, the two lines are just swapped; otherwise, the
+   range is copied first. */
+
+static int *_stalefirst = NULL;         /* range owed to pdc_lastscr */
+static int *_stalelast;
+static int _stalelines = 0, _stalecount = 0;
+
+/* bring line y of pdc_lastscr up to date */
+
+static void _sync_line(int y)
+{
+    int first = _stalefirst[y];
+
+    if (first != _NO_CHANGE)
+    {
+        memcpy(pdc_lastscr->_y[y] + first, curscr->_y[y] + first,
+               (_stalelast[y] - first + 1) * sizeof(chtype));
+
+        PDC_STAT(copied, (_stalelast[y] - first + 1) * sizeof(chtype));
+
+        _stalefirst[y] = _NO_CHANGE;
+        _stalecount--;
+    }
+}
+
+void PDC_sync_lastscr(void)
+{
+    int y;
+
+    for (y = 0; _stalecount && y < _stalelines; y++)
+        _sync_line(y);
+}
+
+/* note that columns first through last of line y of pdc_lastscr
+   should now match curscr */
+
+static void _defer_copy(int y, int first, int last)
+{
+    if (_stalelines != SP->lines)
+    {
+        int i;
+
+        free(_stalefirst);
+
+        _stalefirst = malloc(2 * SP->lines * sizeof(int));
+        _stalelines = _stalefirst ? SP->lines : 0;
+        _stalecount = 0;
+
+        if (!_stalefirst)
+        {
+            memcpy(pdc_lastscr->_y[y] + first, curscr->_y[y] + first,
+                   (last - first + 1) * sizeof(chtype));
+            return;
+        }
+
+        _stalelast = _stalefirst + SP->lines;
+
+        for (i = 0; i < SP->lines; i++)
+            _stalefirst[i] = _NO_CHANGE;
+    }
+
+    if (_stalefirst[y] == _NO_CHANGE)
+    {
+        _stalefirst[y] = first;
+        _stalelast[y] = last;
+        _stalecount++;
+    }
+    else
+    {
+        _stalefirst[y] = min(_stalefirst[y], first);
+        _stalelast[y] = max(_stalelast[y], last);
+    }
+}
+
+/* copy columns first through last of line i of win to curscr */
+
+static void _refresh_span(WINDOW *win, int i, int first, int last)
+{
+    int y = i + win->_begy;
+    chtype *src = win->_y[i];
+    chtype *dest;
+
+    if (_stalecount && _stalefirst[y] != _NO_CHANGE)
+    {
+        /* if the whole line is being replaced, pdc_lastscr can take
+           curscr's copy of it, and curscr gets the old one to
+           overwrite */
+
+        if (!win->_begx && !first && last == SP->cols - 1)
+        {
+            chtype *old = curscr->_y[y];
+
+            curscr->_y[y] = pdc_lastscr->_y[y];
+            pdc_lastscr->_y[y] = old;
+
+            _stalefirst[y] = _NO_CHANGE;
+            _stalecount--;
+
+            memcpy(curscr->_y[y], src, SP->cols * sizeof(chtype));
+
+            PDC_STAT(copied, SP->cols * sizeof(chtype));
+            PDC_STAT(compared, SP->cols);
+
+            first = PDC_first_diff(src, old, SP->cols);
+
+            if (first < SP->cols)
+                PDC_add_span(curscr, y, first,
+                             PDC_last_diff(src, old, SP->cols));
+
+            return;
+        }
+
+        _sync_line(y);
+    }
+
+    dest = curscr->_y[y] + win->_begx;
+
+    PDC_STAT(compared, last - first + 1);
+
+    /* ignore areas on the outside that are marked as changed, but
+       really aren't */
+
+    first += PDC_first_diff(src + first, dest + first, last - first + 1);
+
+    if (first <= last)
+        last = first + PDC_last_diff(src + first, dest + first,
+                                     last - first + 1);
+
+    /* if any have really changed... */
+
+    if (first <= last)
+    {
+        memcpy(dest + first, src + first,
+               (last - first + 1) * sizeof(chtype));
+
+        PDC_STAT(copied, (last - first + 1) * sizeof(chtype));
+
+        PDC_add_span(curscr, y, first + win->_begx, last + win->_begx);
+    }
+}
+
 int wnoutrefresh(WINDOW *win)
 {
     int begy, begx;     /* window's place on screen   */
-    int i, j;
+    int i;
+    PDC_STAT_START(start);
 
     PDC_LOG(("wnoutrefresh() - called: win=%p\n", win));
 
@@ -72,42 +245,21 @@ int wnoutrefresh(WINDOW *win)
     begy = win->_begy;
     begx = win->_begx;
 
-    for (i = 0, j = begy; i < win->_maxy; i++, j++)
+    for (i = 0; i < win->_maxy; i++)
     {
         if (win->_firstch[i] != _NO_CHANGE)
         {
-            chtype *src = win->_y[i];
-            chtype *dest = curscr->_y[j] + begx;
-
-            int first = win->_firstch[i]; /* first changed */
-            int last = win->_lastch[i];   /* last changed */
-
-            /* ignore areas on the outside that are marked as changed,
-               but really aren't */
-
-            while (first <= last && src[first] == dest[first])
-                first++;
-
-            while (last >= first && src[last] == dest[last])
-                last--;
-
-            /* if any have really changed... */
+            int *sp = win->_spans ? win->_spans + i * PDC_SPAN_STRIDE : NULL;
 
-            if (first <= last)
+            if (sp && sp[0])
             {
-                memcpy(dest + first, src + first,
-                       (last - first + 1) * sizeof(chtype));
+                int k;
 
-                first += begx;
-                last += begx;
-
-                if (first < curscr->_firstch[j] ||
-                    curscr->_firstch[j] == _NO_CHANGE)
-                    curscr->_firstch[j] = first;
-
-                if (last > curscr->_lastch[j])
-                    curscr->_lastch[j] = last;
+                for (k = 0; k < sp[0]; k++)
+                    _refresh_span(win, i, sp[1 + k * 2], sp[2 + k * 2]);
             }
+            else
+                _refresh_span(win, i, win->_firstch[i], win->_lastch[i]);
 
             win->_firstch[i] = _NO_CHANGE;  /* updated now */
         }
@@ -124,6 +276,612 @@ int wnoutrefresh(WINDOW *win)
         curscr->_curx = win->_curx + begx;
     }
 
+    PDC_STAT_TIME(refresh_us, start);
+
+    return OK;
+}
+
+/* Return the length of the run of changed cells starting at src, out
+   of n cells. If two runs are separated by a single unchanged cell,
+   the break is ignored, and they're treated as one run. */
+
+static int _run_length(const chtype *src, const chtype *dest, int n)
+{
+    int len = 0;
+
+    while (len < n)
+    {
+        len += PDC_first_same(src + len, dest + len, n - len);
+
+        if (!len || len >= n - 1 || src[len + 1] == dest[len + 1])
+            break;
+
+        len++;
+    }
+
+    return len;
+}
+
+/* Return the first line of curscr, from y on, that's marked in the
+   dirty bitmap, or SP->lines if there are none */
+
+static int _next_dirty(int y)
+{
+    unsigned long *map = curscr->_dirty;
+    int i = (int)(y / PDC_DIRTY_BITS);
+    unsigned long bits;
+
+    if (y >= SP->lines)
+        return SP->lines;
+
+    bits = map[i] & (~0UL << (y % PDC_DIRTY_BITS));
+
+    while (!bits)
+    {
+        if (++i >= (int)PDC_DIRTY_WORDS(SP->lines))
+            return SP->lines;
+
+        bits = map[i];
+    }
+
+#if defined(__GNUC__) || defined(__clang__)
+    y = i * PDC_DIRTY_BITS + __builtin_ctzl(bits);
+#else
+    for (y = i * PDC_DIRTY_BITS; !(bits & 1); bits >>= 1)
+        y++;
+#endif
+    return min(y, SP->lines);
+}
+
+/* Scroll detection. A hash is kept for each line of pdc_lastscr, and
+   computed for each changed line of curscr; a block of lines whose new
+   hashes match the old ones at a vertical offset is handed to
+   PDC_scroll_region(), so that only the lines it uncovers need to be
+   redrawn. This is the same idea as ncurses' hashmap. */
+
+#define _MIN_SCROLL_GAIN 2  /* lines saved before a scroll is worth it */
+#define _MAX_SCROLLS     4  /* regions scrolled per doupdate() */
+
+static unsigned long *_oldhash = NULL;  /* lines of pdc_lastscr */
+static unsigned long *_newhash;         /* lines of curscr */
+static int *_hashrow;                   /* old hash lookup table */
+static void *_rottmp;                   /* scratch for _rotate() */
+static bool *_redraw;                   /* lines left by a scroll */
+static int _hashlines = 0, _hashsize;
+static bool _hashok = FALSE;            /* _oldhash is up to date */
+static bool _hashnew = FALSE;           /* _newhash is, this update */
+
+static unsigned long _hash_line(const chtype *p, int n)
+{
+    unsigned long h = 0;
+
+    while (n--)
+        h = (h << 5) + h + *p++;
+
+    return h;
+}
+
+static bool _hash_alloc(void)
+{
+    size_t lines = SP->lines;
+
+    if (_hashlines == SP->lines)
+        return TRUE;
+
+    free(_oldhash);
+
+    for (_hashsize = 16; _hashsize < SP->lines * 2; _hashsize <<= 1)
+        ;
+
+    /* one block: two hash arrays, the lookup table, rotation scratch
+       space (for either hashes or line pointers), and the flags */
+
+    _oldhash = malloc(lines * sizeof(unsigned long) * 2 +
+                      _hashsize * sizeof(int) +
+                      lines * max(sizeof(unsigned long), sizeof(chtype *)) +
+                      lines * sizeof(bool));
+
+    _hashok = FALSE;
+
+    if (!_oldhash)
+    {
+        _hashlines = 0;
+        return FALSE;
+    }
+
+    _newhash = _oldhash + lines;
+    _hashrow = (int *)(_newhash + lines);
+    _rottmp = _hashrow + _hashsize;
+    _redraw = (bool *)((char *)_rottmp +
+              lines * max(sizeof(unsigned long), sizeof(chtype *)));
+
+    memset(_redraw, 0, lines * sizeof(bool));
+    _hashlines = SP->lines;
+
+    return TRUE;
+}
+
+/* Rotate elements top through bottom of an array by n, as the lines of
+   the physical screen are rotated by PDC_scroll_region() */
+
+static void _rotate(void *base, size_t size, int top, int bottom, int n)
+{
+    char *p = base;
+    int count = bottom - top + 1;
+
+    if (n > 0)
+    {
+        memcpy(_rottmp, p + top * size, n * size);
+        memmove(p + top * size, p + (top + n) * size, (count - n) * size);
+        memcpy(p + (bottom - n + 1) * size, _rottmp, n * size);
+    }
+    else
+    {
+        n = -n;
+        memcpy(_rottmp, p + (bottom - n + 1) * size, n * size);
+        memmove(p + (top + n) * size, p + top * size, (count - n) * size);
+        memcpy(p + top * size, _rottmp, n * size);
+    }
+}
+
+/* Look up an old line by hash; returns -1 if there's none, or if more
+   than one line has that hash */
+
+static int _hash_find(unsigned long h)
+{
+    int i = (int)(h & (_hashsize - 1));
+
+    while (_hashrow[i] != -1)
+    {
+        if (_hashrow[i] >= 0 && _oldhash[_hashrow[i]] == h)
+            return _hashrow[i];
+
+        if (_hashrow[i] < -1 && _oldhash[-2 - _hashrow[i]] == h)
+            return -1;
+
+        i = (i + 1) & (_hashsize - 1);
+    }
+
+    return -1;
+}
+
+static void _hash_table(void)
+{
+    int y;
+
+    for (y = 0; y < _hashsize; y++)
+        _hashrow[y] = -1;
+
+    for (y = 0; y < SP->lines; y++)
+    {
+        unsigned long h = _oldhash[y];
+        int i = (int)(h & (_hashsize - 1));
+
+        /* a duplicate is marked as -2 - line, so it can't match */
+
+        while (_hashrow[i] != -1)
+        {
+            int row = (_hashrow[i] < -1) ? -2 - _hashrow[i] : _hashrow[i];
+
+            if (_oldhash[row] == h)
+            {
+                _hashrow[i] = -2 - row;
+                break;
+            }
+
+            i = (i + 1) & (_hashsize - 1);
+        }
+
+        if (_hashrow[i] == -1)
+            _hashrow[i] = y;
+    }
+}
+
+static bool _scroll_region(int top, int bottom, int n)
+{
+    bool done;
+    PDC_STAT_START(start);
+
+    done = PDC_scroll_region(top, bottom, n);
+
+    PDC_STAT_TIME(platform_us, start);
+    PDC_STAT(scrolls, done);
+
+    return done;
+}
+
+/* Find the shifted block that saves the most redrawn lines, and scroll
+   it into place. Returns TRUE if something was scrolled. */
+
+static bool _scroll_once(void)
+{
+    int y, best_s = 0, best_e = 0, best_n = 0, best_gain = 0;
+    int top, bottom;
+
+    _hash_table();
+
+    for (y = 0; y < SP->lines; y++)
+    {
+        int i, n, s, e, gain;
+
+        if (_newhash[y] == _oldhash[y])
+            continue;
+
+        i = _hash_find(_newhash[y]);
+
+        if (i == -1)
+            continue;
+
+        /* grow the block in both directions, taking in repeated lines
+           (like blanks) that the lookup alone can't place */
+
+        n = i - y;
+
+        for (s = y; s > 0 && s - 1 + n >= 0 &&
+             _newhash[s - 1] == _oldhash[s - 1 + n]; s--)
+            ;
+
+        for (e = y; e < SP->lines - 1 && e + 1 + n < SP->lines &&
+             _newhash[e + 1] == _oldhash[e + 1 + n]; e++)
+            ;
+
+        /* lines that would have been redrawn, less those uncovered */
+
+        for (gain = -abs(n), i = s; i <= e; i++)
+            if (_newhash[i] != _oldhash[i])
+                gain++;
+
+        if (gain > best_gain)
+        {
+            best_s = s;
+            best_e = e;
+            best_n = n;
+            best_gain = gain;
+        }
+
+        y = e;
+    }
+
+    if (best_gain < _MIN_SCROLL_GAIN)
+        return FALSE;
+
+    /* the hashes could collide, so check the real contents */
+
+    for (y = best_s; y <= best_e; y++)
+        if (memcmp(curscr->_y[y], pdc_lastscr->_y[y + best_n],
+                   SP->cols * sizeof(chtype)))
+            return FALSE;
+
+    top = (best_n > 0) ? best_s : best_s + best_n;
+    bottom = (best_n > 0) ? best_e + best_n : best_e;
+
+    if (!_scroll_region(top, bottom, best_n))
+        return FALSE;
+
+    /* make pdc_lastscr match the screen, and have the uncovered lines
+       redrawn in full */
+
+    _rotate(pdc_lastscr->_y, sizeof(chtype *), top, bottom, best_n);
+    _rotate(_oldhash, sizeof(unsigned long), top, bottom, best_n);
+
+    if (best_n > 0)
+        top = bottom - best_n + 1;
+    else
+        bottom = top - best_n - 1;
+
+    for (y = top; y <= bottom; y++)
+    {
+        _redraw[y] = TRUE;
+        _oldhash[y] = ~_newhash[y];
+
+        curscr->_firstch[y] = 0;
+        curscr->_lastch[y] = SP->cols - 1;
+        PDC_SET_DIRTY(curscr, y);
+    }
+
+    return TRUE;
+}
+
+static void _find_scrolls(void)
+{
+    int y, changed = 0;
+
+    _hashnew = FALSE;
+
+    if (!PDC_scroll_region(0, 0, 0))
+    {
+        _hashok = FALSE;
+        return;
+    }
+
+    if (!_hash_alloc())
+        return;
+
+    if (!_hashok)
+    {
+        for (y = 0; y < SP->lines; y++)
+            _oldhash[y] = _hash_line(pdc_lastscr->_y[y], SP->cols);
+
+        _hashok = TRUE;
+    }
+
+    /* with only a few changed lines, there's nothing to gain; doupdate()
+       just rehashes them as it goes */
+
+    for (y = _next_dirty(0); y < SP->lines && changed <= _MIN_SCROLL_GAIN;
+         y = _next_dirty(y + 1))
+        if (curscr->_firstch[y] != _NO_CHANGE)
+            changed++;
+
+    if (changed <= _MIN_SCROLL_GAIN)
+        return;
+
+    memcpy(_newhash, _oldhash, SP->lines * sizeof(unsigned long));
+
+    for (changed = 0, y = _next_dirty(0); y < SP->lines;
+         y = _next_dirty(y + 1))
+        if (curscr->_firstch[y] != _NO_CHANGE)
+        {
+            _newhash[y] = _hash_line(curscr->_y[y], SP->cols);
+
+            if (_newhash[y] != _oldhash[y])
+                changed++;
+        }
+
+    _hashnew = TRUE;
+
+    if (changed > _MIN_SCROLL_GAIN)
+        for (y = 0; y < _MAX_SCROLLS; y++)
+            if (!_scroll_once())
+                break;
+}
+
+/* The runs for an update are collected, and handed to the platform
+   layer together at the end */
+
+static FRAMERUN *_runs = NULL;
+static int _runcount = 0, _runmax = 0;
+
+static void _add_run(int y, int x, int len, const chtype *text)
+{
+    if (_runcount == _runmax)
+    {
+        int newmax = _runmax ? _runmax * 2 : 64;
+        FRAMERUN *newruns = realloc(_runs, newmax * sizeof(FRAMERUN));
+
+        /* if there's no room, just send this one now */
+
+        if (!newruns)
+        {
+            PDC_transform_line(y, x, len, text);
+            return;
+        }
+
+        _runs = newruns;
+        _runmax = newmax;
+    }
+
+    _runs[_runcount].y = y;
+    _runs[_runcount].x = x;
+    _runs[_runcount].len = len;
+    _runs[_runcount].text = text;
+    _runcount++;
+
+    PDC_STAT(runs, 1);
+    PDC_STAT(changed, len);
+}
+
+static void _send_frame(int cury, int curx)
+{
+    PDC_STAT_START(start);
+
+    if (!PDC_transform_frame(_runs, _runcount, cury, curx))
+    {
+        int i;
+
+        for (i = 0; i < _runcount; i++)
+            PDC_transform_line(_runs[i].y, _runs[i].x, _runs[i].len,
+                               _runs[i].text);
+
+        if (SP->visibility)
+            PDC_gotoyx(cury, curx);
+    }
+
+    _runcount = 0;
+
+    PDC_STAT_TIME(platform_us, start);
+}
+
+/* With a frame rate limit, doupdate() does nothing until _frame_ms
+   have passed since the last frame, leaving its changes pending. */
+
+static unsigned long _frame_ms = 0;     /* 0 = no limit */
+static unsigned long _last_frame;       /* from PDC_ms_count() */
+static bool _pending = FALSE;           /* a doupdate() was put off */
+
+/* Collect the changed runs in columns first through last of line y,
+   widening *done_first and *done_last to cover them. With redraw set,
+   the whole range is sent. */
+
+static void _update_span(int y, int first, int last, bool redraw,
+                         int *done_first, int *done_last)
+{
+    chtype *src = curscr->_y[y];
+    chtype *dest = pdc_lastscr->_y[y];
+
+    if (!redraw)
+        PDC_STAT(compared, last - first + 1);
+
+    while (first <= last)
+    {
+        int len;
+
+        /* build up a run of changed cells */
+
+        if (redraw)
+            len = last - first + 1;
+        else
+            len = _run_length(src + first, dest + first, last - first + 1);
+
+        /* update the screen */
+
+        if (len)
+        {
+            _add_run(y, first, len, src + first);
+
+            if (*done_first == _NO_CHANGE || first < *done_first)
+                *done_first = first;
+
+            first += len;
+
+            if (first - 1 > *done_last)
+                *done_last = first - 1;
+        }
+
+        /* skip over runs of unchanged cells */
+
+        if (first <= last)
+            first += PDC_first_diff(src + first, dest + first,
+                                    last - first + 1);
+    }
+}
+
+static void _update_line(int y, bool redraw)
+{
+    int *sp = curscr->_spans ? curscr->_spans + y * PDC_SPAN_STRIDE : NULL;
+    int done_first = _NO_CHANGE, done_last = _NO_CHANGE;
+
+    if (redraw)
+        _update_span(y, 0, COLS - 1, TRUE, &done_first, &done_last);
+    else if (sp && sp[0])
+    {
+        int k;
+
+        for (k = 0; k < sp[0]; k++)
+            _update_span(y, sp[1 + k * 2], sp[2 + k * 2], FALSE,
+                         &done_first, &done_last);
+    }
+    else
+        _update_span(y, curscr->_firstch[y], curscr->_lastch[y], FALSE,
+                     &done_first, &done_last);
+
+    /* update pdc_lastscr; any unchanged cells between the runs already
+       match, so one range covers them all */
+
+    if (done_first != _NO_CHANGE)
+        _defer_copy(y, done_first, done_last);
+}
+
+void PDC_refresh_free(void)
+{
+    free(_oldhash);
+    free(_runs);
+    free(_stalefirst);
+
+    _oldhash = NULL;
+    _runs = NULL;
+    _stalefirst = NULL;
+    _stalelines = 0;
+    _stalecount = 0;
+    _runmax = 0;
+    _hashlines = 0;
+    _hashok = FALSE;
+    _hashnew = FALSE;
+    _pending = FALSE;
+}
+
+#ifdef PDC_STATS
+PDC_REFRESH_STATS pdc_stats;            /* the frame in progress */
+static PDC_REFRESH_STATS _total, _last;
+
+/* the fields are all unsigned longs, so they're summed as an array */
+
+# define _NSTATS (sizeof(PDC_REFRESH_STATS) / sizeof(unsigned long))
+#endif
+
+/* a frame has been drawn; move its counts to the totals */
+
+static void _stats_frame(void)
+{
+#ifdef PDC_STATS
+    unsigned long *from = (unsigned long *)&pdc_stats;
+    unsigned long *to = (unsigned long *)&_total;
+    size_t i;
+
+    for (i = 0; i < _NSTATS; i++)
+        to[i] += from[i];
+
+    _last = pdc_stats;
+    memset(&pdc_stats, 0, sizeof(PDC_REFRESH_STATS));
+#endif
+}
+
+int PDC_get_refresh_stats(PDC_REFRESH_STATS *total, PDC_REFRESH_STATS *last)
+{
+    PDC_LOG(("PDC_get_refresh_stats() - called\n"));
+
+#ifdef PDC_STATS
+    if (total)
+        *total = _total;
+
+    if (last)
+        *last = _last;
+
+    return OK;
+#else
+    return ERR;
+#endif
+}
+
+int PDC_reset_refresh_stats(void)
+{
+    PDC_LOG(("PDC_reset_refresh_stats() - called\n"));
+
+#ifdef PDC_STATS
+    memset(&pdc_stats, 0, sizeof(PDC_REFRESH_STATS));
+    memset(&_total, 0, sizeof(PDC_REFRESH_STATS));
+    memset(&_last, 0, sizeof(PDC_REFRESH_STATS));
+
+    return OK;
+#else
+    return ERR;
+#endif
+}
+
+/* draw any update put off by the frame rate limit */
+
+void PDC_refresh_flush(void)
+{
+    if (_pending)
+    {
+        _last_frame = PDC_ms_count() - _frame_ms;
+        doupdate();
+    }
+}
+
+/* draw any update put off by the frame rate limit, if the limit now
+   allows it; otherwise, it stays put off */
+
+void PDC_refresh_pending(void)
+{
+    if (_pending)
+        doupdate();
+}
+
+int PDC_set_max_fps(int fps)
+{
+    PDC_LOG(("PDC_set_max_fps() - called: fps=%d\n", fps));
+
+    if (fps < 0)
+        return ERR;
+
+    _frame_ms = fps ? (1000 + fps - 1) / fps : 0;
+
+    if (_frame_ms)
+        _last_frame = PDC_ms_count() - _frame_ms;
+    else
+        PDC_refresh_flush();
+
     return OK;
 }
 
@@ -131,12 +889,30 @@ int doupdate(void)
 {
     int y;
     bool clearall;
+    PDC_STAT_START(start);
 
     PDC_LOG(("doupdate() - called\n"));
 
     if (!curscr)
         return ERR;
 
+    if (_frame_ms && !isendwin())
+    {
+        unsigned long now = PDC_ms_count();
+
+        if (now - _last_frame < _frame_ms)
+        {
+            _pending = TRUE;
+            return OK;
+        }
+
+        _last_frame = now;
+    }
+
+    _pending = FALSE;
+
+    PDC_sync_lastscr();
+
     if (isendwin())         /* coming back after endwin() called */
     {
         reset_prog_mode();
@@ -146,64 +922,44 @@ int doupdate(void)
     else
         clearall = curscr->_clear;
 
-    for (y = 0; y < SP->lines; y++)
+    if (clearall)
+        _hashok = FALSE;
+    else
+        _find_scrolls();
+
+    /* visit every line on a full redraw; otherwise, only the ones
+       marked in the dirty bitmap */
+
+    for (y = clearall ? 0 : _next_dirty(0); y < SP->lines;
+         y = clearall ? y + 1 : _next_dirty(y + 1))
     {
         PDC_LOG(("doupdate() - Transforming line %d of %d: %s\n",
                  y, SP->lines, (curscr->_firstch[y] != _NO_CHANGE) ?
                  "Yes" : "No"));
 
+        curscr->_dirty[y / PDC_DIRTY_BITS] &=
+            ~(1UL << (y % PDC_DIRTY_BITS));
+
+        PDC_STAT(lines, 1);
+
         if (clearall || curscr->_firstch[y] != _NO_CHANGE)
         {
-            int first, last;
+            bool redraw = clearall;
 
-            chtype *src = curscr->_y[y];
-            chtype *dest = pdc_lastscr->_y[y];
-
-            if (clearall)
+            if (_hashok)
             {
-                first = 0;
-                last = COLS - 1;
-            }
-            else
-            {
-                first = curscr->_firstch[y];
-                last = curscr->_lastch[y];
-            }
+                redraw = redraw || _redraw[y];
+                _redraw[y] = FALSE;
 
-            while (first <= last)
-            {
-                int len = 0;
-
-                /* build up a run of changed cells; if two runs are
-                   separated by a single unchanged cell, ignore the
-                   break */
-
-                if (clearall)
-                    len = last - first + 1;
-                else
-                    while (first + len <= last &&
-                           (src[first + len] != dest[first + len] ||
-                            (len && first + len < last &&
-                             src[first + len + 1] != dest[first + len + 1])
-                           )
-                          )
-                        len++;
-
-                /* update the screen, and pdc_lastscr */
-
-                if (len)
-                {
-                    PDC_transform_line(y, first, len, src + first);
-                    memcpy(dest + first, src + first, len * sizeof(chtype));
-                    first += len;
-                }
-
-                /* skip over runs of unchanged cells */
-
-                while (first <= last && src[first] == dest[first])
-                    first++;
+                if (_hashnew)
+                    _oldhash[y] = _newhash[y];
             }
 
+            _update_line(y, redraw);
+
+            if (_hashok && !_hashnew)
+                _oldhash[y] = _hash_line(curscr->_y[y], SP->cols);
+
             curscr->_firstch[y] = _NO_CHANGE;
             curscr->_lastch[y] = _NO_CHANGE;
         }
@@ -211,12 +967,16 @@ int doupdate(void)
 
     curscr->_clear = FALSE;
 
-    if (SP->visibility)
-        PDC_gotoyx(curscr->_cury, curscr->_curx);
+    _send_frame(curscr->_cury, curscr->_curx);
 
     SP->cursrow = curscr->_cury;
     SP->curscol = curscr->_curx;
 
+    PDC_STAT(frames, 1);
+    PDC_STAT_TIME(update_us, start);
+
+    _stats_frame();
+
     return OK;
 }
 
@@ -263,6 +1023,7 @@ int wredrawln(WINDOW *win, int start, int num)
     {
         win->_firstch[i] = 0;
         win->_lastch[i] = win->_maxx - 1;
+        PDC_SET_DIRTY(win, i);
     }
 
     return OK;
@@ -24,7 +24,9 @@ scr_dump
 
    putwin() writes all data associated with a window into a file,
    using an unspecified format. This information can be retrieved
-   later using getwin().
+   later using getwin(). In PDCurses, the format is the same as for
+   the file of a pad from PDC_map_pad(), so getwin() can read that,
+   too.
 
    scr_dump() writes the current contents of the virtual screen to
    the file named by filename in an unspecified format.
@@ -58,16 +60,12 @@ scr_dump
 
 **man-end****************************************************************/
 
-#include <stdlib.h>
 #include <string.h>
 
-#define DUMPVER 1   /* Should be updated whenever the WINDOW struct is
-                       changed */
-
 int putwin(WINDOW *win, FILE *filep)
 {
     static const char *marker = "PDC";
-    static const unsigned char version = DUMPVER;
+    static const unsigned char version = PDC_DUMPVER;
 
     PDC_LOG(("putwin() - called\n"));
 
@@ -93,61 +91,41 @@ int putwin(WINDOW *win, FILE *filep)
 
 WINDOW *getwin(FILE *filep)
 {
-    WINDOW *win;
+    WINDOW *win, saved;
     char marker[4];
     int i, nlines, ncols;
 
     PDC_LOG(("getwin() - called\n"));
 
-    win = malloc(sizeof(WINDOW));
-    if (!win)
-        return (WINDOW *)NULL;
-
     /* check for the marker, and load the WINDOW struct */
 
     if (!filep || !fread(marker, 4, 1, filep) || strncmp(marker, "PDC", 3)
-        || marker[3] != DUMPVER || !fread(win, sizeof(WINDOW), 1, filep))
-    {
-        free(win);
+        || marker[3] != PDC_DUMPVER
+        || !fread(&saved, sizeof(WINDOW), 1, filep))
         return (WINDOW *)NULL;
-    }
-
-    nlines = win->_maxy;
-    ncols = win->_maxx;
 
-    /* allocate the line pointer array */
+    nlines = saved._maxy;
+    ncols = saved._maxx;
 
-    win->_y = malloc(nlines * sizeof(chtype *));
-    if (!win->_y)
-    {
-        free(win);
-        return (WINDOW *)NULL;
-    }
+    /* allocate the window and its lines */
 
-    /* allocate the minchng and maxchng arrays */
+    win = PDC_makenew(nlines, ncols, saved._begy, saved._begx);
+    if (win)
+        win = PDC_makelines(win);
 
-    win->_firstch = malloc(nlines * sizeof(int));
-    if (!win->_firstch)
-    {
-        free(win->_y);
-        free(win);
+    if (!win)
         return (WINDOW *)NULL;
-    }
 
-    win->_lastch = malloc(nlines * sizeof(int));
-    if (!win->_lastch)
-    {
-        free(win->_firstch);
-        free(win->_y);
-        free(win);
-        return (WINDOW *)NULL;
-    }
+    /* keep the new arrays, and take everything else from the file */
 
-    /* allocate the lines */
+    saved._y = win->_y;
+    saved._firstch = win->_firstch;
+    saved._lastch = win->_lastch;
+    saved._dirty = win->_dirty;
+    saved._spans = win->_spans;
 
-    win = PDC_makelines(win);
-    if (!win)
-        return (WINDOW *)NULL;
+    *win = saved;
+    win->_flags &= ~(_PAGED | _MAPPED);
 
     /* read them */
 
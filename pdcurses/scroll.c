@@ -13,6 +13,8 @@ scroll
     int scrl(int n);
     int wscrl(WINDOW *win, int n);
 
+    int PDC_shift_lines(WINDOW *win, int top, int bottom, int n);
+
 ### Description
 
    scroll() causes the window to scroll up one line.  This involves
@@ -26,6 +28,15 @@ scroll
    scrollok(). Note also that scrolling is not allowed if the
    supplied window is a pad.
 
+   PDC_shift_lines() does the work for these functions and for
+   winsdelln(). It moves lines top through bottom of the window up n
+   lines (down, if n is negative), fills the lines left behind with
+   the window's background, and marks the range as changed. The
+   line pointers are rotated in one pass, however large n is (in a
+   pad from PDC_map_pad(), the lines are moved in one copy), and
+   only the lines left behind are cleared. It returns ERR only if a
+   paged pad runs out of memory.
+
 ### Return Value
 
    All functions return OK on success and ERR on error.
@@ -35,52 +46,117 @@ scroll
     scroll                      Y       Y       Y
     scrl                        Y       -      4.0
     wscrl                       Y       -      4.0
+    PDC_shift_lines             -       -       -
 
 **man-end****************************************************************/
 
-int wscrl(WINDOW *win, int n)
+#include <string.h>
+
+static void _reverse(chtype **lines, int first, int last)
 {
-    int i, l, dir, start, end;
-    chtype blank, *temp;
+    while (first < last)
+    {
+        chtype *temp = lines[first];
 
-    /* Check if window scrolls. Valid for window AND pad */
+        lines[first++] = lines[last];
+        lines[last--] = temp;
+    }
+}
 
-    if (!win || !win->_scroll || !n)
-        return ERR;
+int PDC_shift_lines(WINDOW *win, int top, int bottom, int n)
+{
+    chtype blank = win->_bkgd, *line = NULL;
+    int count = bottom - top + 1;
+    int i, k, first, nblank;
+
+    if (count < 1)
+        return OK;
+
+    if (n > count)
+        n = count;
+    else if (n < -count)
+        n = -count;
+
+    k = (n > 0) ? n : count + n;
+
+    /* the lines of a mapped pad must stay in file order, and follow
+       each other there, so they're moved with one copy */
+
+    if (win->_flags & _MAPPED)
+    {
+        size_t len = win->_maxx * sizeof(chtype);
+
+        if (n > 0 && n < count)
+            memmove(win->_y[top], win->_y[top + n], (count - n) * len);
+        else if (n < 0 && n > -count)
+            memmove(win->_y[top - n], win->_y[top], (count + n) * len);
+    }
 
-    blank = win->_bkgd;
+    /* otherwise, rotate the line pointers left by k, by reversing each
+       part and then the whole */
+
+    else if (k % count)
+    {
+        _reverse(win->_y, top, top + k - 1);
+        _reverse(win->_y, top + k, bottom);
+        _reverse(win->_y, top, bottom);
+    }
+
+    for (i = top; i <= bottom; i++)
+    {
+        win->_firstch[i] = 0;
+        win->_lastch[i] = win->_maxx - 1;
+        PDC_SET_DIRTY(win, i);
+    }
+
+    /* clear the lines that moved in; one is filled, then copied, and
+       in a paged pad, they can just go back to being blank */
 
     if (n > 0)
     {
-        start = win->_tmarg;
-        end = win->_bmarg;
-        dir = 1;
+        first = bottom - n + 1;
+        nblank = n;
     }
     else
     {
-        start = win->_bmarg;
-        end = win->_tmarg;
-        dir = -1;
+        first = top;
+        nblank = -n;
     }
 
-    for (l = 0; l < (n * dir); l++)
+    for (k = first; k < first + nblank; k++)
     {
-        temp = win->_y[start];
-
-        /* re-arrange line pointers */
+        chtype *dest;
 
-        for (i = start; i != end; i += dir)
-            win->_y[i] = win->_y[i + dir];
+        if (PDC_page_clear(win, k, blank))
+            continue;
 
-        win->_y[end] = temp;
+        dest = PDC_LINE(win, k);
+        if (!dest)
+            return ERR;
 
-        /* make a blank line */
+        if (line)
+            memcpy(dest, line, win->_maxx * sizeof(chtype));
+        else
+        {
+            for (i = 0; i < win->_maxx; i++)
+                dest[i] = blank;
 
-        for (i = 0; i < win->_maxx; i++)
-            *temp++ = blank;
+            line = dest;
+        }
     }
 
-    touchline(win, win->_tmarg, win->_bmarg - win->_tmarg + 1);
+    return OK;
+}
+
+int wscrl(WINDOW *win, int n)
+{
+    /* Check if window scrolls. Valid for window AND pad */
+
+    if (!win || !win->_scroll || !n)
+        return ERR;
+
+    if (PDC_shift_lines(win, win->_tmarg, win->_bmarg, n) == ERR)
+        return ERR;
 
     PDC_sync(win);
     return OK;
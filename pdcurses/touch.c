@@ -16,6 +16,8 @@ touch
     bool is_linetouched(WINDOW *win, int line);
     bool is_wintouched(WINDOW *win);
 
+    void PDC_add_span(WINDOW *win, int y, int first, int last);
+
 ### Description
 
    touchwin() and touchline() throw away all information about
@@ -40,6 +42,11 @@ touch
    is_wintouched() returns TRUE if the specified window
    has been changed since the last call to wrefresh().
 
+   PDC_add_span() marks columns first through last of line y as
+   changed. If the window keeps damage spans (see
+   PDC_set_damage_spans()), the range is merged into the line's
+   list; when the list is full, the two closest ranges are joined.
+
 ### Return Value
 
    All functions return OK on success and ERR on error except
@@ -53,6 +60,7 @@ touch
     wtouchln                    Y       Y       Y
     is_linetouched              Y       -      4.0
     is_wintouched               Y       -      4.0
+    PDC_add_span                -       -       -
 
 **man-end****************************************************************/
 
@@ -69,6 +77,7 @@ int touchwin(WINDOW *win)
     {
         win->_firstch[i] = 0;
         win->_lastch[i] = win->_maxx - 1;
+        PDC_SET_DIRTY(win, i);
     }
 
     return OK;
@@ -88,6 +97,7 @@ int touchline(WINDOW *win, int start, int count)
     {
         win->_firstch[i] = 0;
         win->_lastch[i] = win->_maxx - 1;
+        PDC_SET_DIRTY(win, i);
     }
 
     return OK;
@@ -127,6 +137,7 @@ int wtouchln(WINDOW *win, int y, int n, int changed)
         {
             win->_firstch[i] = 0;
             win->_lastch[i] = win->_maxx - 1;
+            PDC_SET_DIRTY(win, i);
         }
         else
         {
@@ -161,3 +172,109 @@ bool is_wintouched(WINDOW *win)
 
     return FALSE;
 }
+
+void PDC_add_span(WINDOW *win, int y, int first, int last)
+{
+    int f[PDC_MAXSPANS + 1], l[PDC_MAXSPANS + 1];
+    int *sp, i, n, count;
+    bool placed;
+
+    PDC_DIRTY_BIT(win, y);
+
+    sp = win->_spans ? win->_spans + y * PDC_SPAN_STRIDE : NULL;
+
+    if (win->_firstch[y] == _NO_CHANGE)
+    {
+        win->_firstch[y] = first;
+        win->_lastch[y] = last;
+
+        if (sp)
+        {
+            sp[0] = 1;
+            sp[1] = first;
+            sp[2] = last;
+        }
+
+        return;
+    }
+
+    if (first < win->_firstch[y])
+        win->_firstch[y] = first;
+
+    if (last > win->_lastch[y])
+        win->_lastch[y] = last;
+
+    /* nothing more to do if only the outer edges are known */
+
+    if (!sp || !sp[0])
+        return;
+
+    /* rebuild the list in order, absorbing any ranges that overlap or
+       touch the new one */
+
+    count = sp[0];
+    placed = FALSE;
+
+    for (i = n = 0; i < count; i++)
+    {
+        int sf = sp[1 + i * 2], sl = sp[2 + i * 2];
+
+        if (sl + 1 < first)
+        {
+            f[n] = sf;
+            l[n++] = sl;
+        }
+        else if (sf > last + 1)
+        {
+            if (!placed)
+            {
+                f[n] = first;
+                l[n++] = last;
+                placed = TRUE;
+            }
+
+            f[n] = sf;
+            l[n++] = sl;
+        }
+        else
+        {
+            first = min(first, sf);
+            last = max(last, sl);
+        }
+    }
+
+    if (!placed)
+    {
+        f[n] = first;
+        l[n++] = last;
+    }
+
+    /* if that's one too many, join the pair with the smallest gap */
+
+    if (n > PDC_MAXSPANS)
+    {
+        int j = 0;
+
+        for (i = 1; i < n - 1; i++)
+            if (f[i + 1] - l[i] < f[j + 1] - l[j])
+                j = i;
+
+        l[j] = l[j + 1];
+
+        for (i = j + 1; i < n - 1; i++)
+        {
+            f[i] = f[i + 1];
+            l[i] = l[i + 1];
+        }
+
+        n--;
+    }
+
+    sp[0] = n;
+
+    for (i = 0; i < n; i++)
+    {
+        sp[1 + i * 2] = f[i];
+        sp[2 + i * 2] = l[i];
+    }
+}
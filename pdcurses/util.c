@@ -23,6 +23,8 @@ util
     int PDC_mbtowc(wchar_t *pwc, const char *s, size_t n);
     size_t PDC_mbstowcs(wchar_t *dest, const char *src, size_t n);
     size_t PDC_wcstombs(char *dest, const wchar_t *src, size_t n);
+    int PDC_mbsntowcs(wchar_t *dest, int max, const char *src, int len,
+                      int *used);
 
 ### Description
 
@@ -52,6 +54,18 @@ util
    combining characters). Nor will it correctly handle any
    character outside the basic multilingual plane (UCS-2).
 
+   PDC_mbtowc(), PDC_mbstowcs() and PDC_wcstombs() are versions of
+   the standard functions which, when PDCurses is built with
+   PDC_FORCE_UTF8, always use UTF-8. PDC_mbsntowcs() converts a
+   whole buffer at once: up to len bytes of src, stopping at a NUL,
+   into at most max wide characters at dest. It stores the number
+   of bytes it used in *used, if used isn't NULL, and returns the
+   number of characters. A character cut off by the end of the
+   buffer is left unused. All len bytes may be read, even past a
+   NUL. With PDC_FORCE_UTF8, runs of ASCII are copied many bytes at
+   a time, and each invalid sequence, or character outside the BMP,
+   becomes U+FFFD.
+
 ### Return Value
 
    unctrl() and wunctrl() return NULL on failure. delay_output()
@@ -74,6 +88,7 @@ util
     PDC_mbtowc                  -       -       -
     PDC_mbstowcs                -       -       -
     PDC_wcstombs                -       -       -
+    PDC_mbsntowcs               -       -       -
 
 **man-end****************************************************************/
 
@@ -187,12 +202,76 @@ wchar_t *wunctrl(cchar_t *wc)
     return strbuf;
 }
 
+# ifdef PDC_FORCE_UTF8
+
+/* Decode the multibyte character at s, which starts with a byte of
+   0x80 or more, and has at most n bytes. Returns its length, or 0 if
+   it's cut off by n. An invalid sequence is the lead byte and any
+   valid continuation bytes after it, and, like a character outside
+   the BMP, it's decoded as U+FFFD. */
+
+static int _utf8_decode(wchar_t *pwc, const unsigned char *s, size_t n)
+{
+    unsigned long key = s[0];
+    unsigned char lo = 0x80, hi = 0xbf;
+    size_t i, len;
+
+    if (key >= 0xc2 && key <= 0xdf)
+    {
+        len = 2;
+        key &= 0x1f;
+    }
+    else if (key >= 0xe0 && key <= 0xef)
+    {
+        len = 3;
+        key &= 0x0f;
+
+        if (s[0] == 0xe0)
+            lo = 0xa0;          /* overlong */
+        else if (s[0] == 0xed)
+            hi = 0x9f;          /* surrogates */
+    }
+    else if (key >= 0xf0 && key <= 0xf4)
+    {
+        len = 4;
+        key &= 0x07;
+
+        if (s[0] == 0xf0)
+            lo = 0x90;
+        else if (s[0] == 0xf4)
+            hi = 0x8f;          /* past U+10FFFF */
+    }
+    else
+    {
+        *pwc = 0xfffd;
+        return 1;
+    }
+
+    for (i = 1; i < len; i++, lo = 0x80, hi = 0xbf)
+    {
+        if (i >= n)
+            return 0;
+
+        if (s[i] < lo || s[i] > hi)
+        {
+            *pwc = 0xfffd;
+            return (int)i;
+        }
+
+        key = (key << 6) | (s[i] & 0x3f);
+    }
+
+    *pwc = (key > 0xffff) ? 0xfffd : (wchar_t)key;
+
+    return (int)len;
+}
+
+# endif
+
 int PDC_mbtowc(wchar_t *pwc, const char *s, size_t n)
 {
 # ifdef PDC_FORCE_UTF8
-    wchar_t key;
-    int i = -1;
-    const unsigned char *string;
+    int i;
 
     if (!s || (n < 1))
         return -1;
@@ -200,65 +279,71 @@ int PDC_mbtowc(wchar_t *pwc, const char *s, size_t n)
     if (!*s)
         return 0;
 
-    string = (const unsigned char *)s;
+    if (!(*s & 0x80))
+    {
+        *pwc = *s;
+        return 1;
+    }
 
-    key = string[0];
+    i = _utf8_decode(pwc, (const unsigned char *)s, n);
 
-    /* Simplistic UTF-8 decoder -- only does the BMP, minimal validation */
+    return i ? i : -1;
+# else
+    return mbtowc(pwc, s, n);
+# endif
+}
 
-    if (key & 0x80)
+int PDC_mbsntowcs(wchar_t *dest, int max, const char *src, int len,
+                  int *used)
+{
+    int i = 0, j = 0;
+
+    while (i < len && j < max && src[i])
     {
-        if ((key & 0xe0) == 0xc0)
-        {
-            if (1 < n)
-            {
-                key = ((key & 0x1f) << 6) | (string[1] & 0x3f);
-                i = 2;
-            }
-        }
-        else if ((key & 0xe0) == 0xe0)
+# ifdef PDC_FORCE_UTF8
+        int run = PDC_ascii_run(src + i, min(len - i, max - j));
+
+        if (run)
         {
-            if (2 < n)
-            {
-                key = ((key & 0x0f) << 12) | ((string[1] & 0x3f) << 6) |
-                      (string[2] & 0x3f);
-                i = 3;
-            }
-        }
-    }
-    else
-        i = 1;
+            const unsigned char *s = (const unsigned char *)src + i;
+            wchar_t *d = dest + j;
+            int k;
 
-    if (i)
-        *pwc = key;
+            for (k = 0; k < run; k++)
+                d[k] = s[k];
 
-    return i;
+            i += run;
+            j += run;
+            continue;
+        }
+
+        run = _utf8_decode(dest + j, (const unsigned char *)src + i,
+                           len - i);
 # else
-    return mbtowc(pwc, s, n);
+        int run = mbtowc(dest + j, src + i, len - i);
 # endif
+        if (run < 1)
+            break;
+
+        i += run;
+        j++;
+    }
+
+    if (used)
+        *used = i;
+
+    return j;
 }
 
 size_t PDC_mbstowcs(wchar_t *dest, const char *src, size_t n)
 {
 # ifdef PDC_FORCE_UTF8
-    size_t i = 0, len;
+    size_t i;
 
     if (!src || !dest)
         return 0;
 
-    len = strlen(src);
-
-    while (*src && i < n)
-    {
-        int retval = PDC_mbtowc(dest + i, src, len);
-
-        if (retval < 1)
-            return -1;
-
-        src += retval;
-        len -= retval;
-        i++;
-    }
+    i = PDC_mbsntowcs(dest, (int)n, src, (int)strlen(src) + 1, NULL);
 # else
     size_t i = mbstowcs(dest, src, n);
 # endif
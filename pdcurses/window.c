@@ -28,6 +28,10 @@ window
     WINDOW *PDC_makelines(WINDOW *win);
     WINDOW *PDC_makenew(int nlines, int ncols, int begy, int begx);
     void PDC_sync(WINDOW *win);
+    int PDC_set_damage_spans(bool on);
+    int PDC_set_window_pool(bool on);
+    int PDC_reserve_windows(int count, int nlines, int ncols);
+    int PDC_get_window_pool(PDC_WINDOW_POOL *stats);
 
 ### Description
 
@@ -90,19 +94,53 @@ window
    PDC_makenew() allocates all data for a new WINDOW * except the
    actual lines themselves. If it's unable to allocate memory for
    the window structure, it will free all allocated memory and
-   return a NULL pointer.
+   return a NULL pointer. The line pointers and change arrays are
+   kept in a single block.
 
-   PDC_makelines() allocates the memory for the lines.
+   PDC_makelines() allocates the memory for the lines, by extending
+   that block, so that they're stored contiguously. If it fails, it
+   frees the window.
 
    PDC_sync() handles wrefresh() and wsyncup() calls when a window
    is changed.
 
+   PDC_set_damage_spans() turns on (or off) tracking of up to
+   PDC_MAXSPANS separate changed ranges per line, instead of just
+   the first and last changed columns. This can save comparing the
+   unchanged cells between sparse updates, as in a table with two
+   columns. Only windows created afterwards are affected, so to
+   include curscr, call it before initscr(). Note that unchanged
+   cells between the ranges are no longer copied by wnoutrefresh(),
+   so as in other curses implementations, an overlapped window must
+   be touched before it's refreshed.
+
+   PDC_set_window_pool() turns on (or off) a pool of memory for
+   windows. With it on, the memory freed by delwin() is kept, in
+   lists by size, and reused for later windows, instead of going
+   back through malloc() and free(). Sizes are rounded up to a power
+   of two, and blocks over 2 MB aren't pooled. Turning the pool off
+   frees the memory it holds.
+
+   PDC_reserve_windows() fills the pool in advance with enough
+   memory for count windows of nlines by ncols (and as many
+   subwindows of up to nlines lines).
+
+   PDC_get_window_pool() reports the pool's use in a
+   PDC_WINDOW_POOL structure: the number of blocks allocated to
+   windows (in_use), the number and total size of those held for
+   reuse (cached, cached_bytes), and how many allocations were
+   served from the pool (hits) and from malloc() (misses) while it
+   was on.
+
 ### Return Value
 
    newwin(), subwin(), derwin() and dupwin() return a pointer
    to the new window, or NULL on failure. delwin(), mvwin(),
-   mvderwin() and syncok() return OK or ERR. wsyncup(),
-   wcursyncup() and wsyncdown() return nothing.
+   mvderwin(), syncok(), PDC_set_damage_spans(),
+   PDC_set_window_pool() and PDC_get_window_pool() return OK or
+   ERR. PDC_reserve_windows() returns ERR if the pool is off, or
+   the memory can't be allocated. wsyncup(), wcursyncup() and
+   wsyncdown() return nothing.
 
 ### Errors
 
@@ -131,51 +169,204 @@ window
     PDC_makelines               -       -       -
     PDC_makenew                 -       -       -
     PDC_sync                    -       -       -
+    PDC_set_damage_spans        -       -       -
+    PDC_set_window_pool         -       -       -
+    PDC_reserve_windows         -       -       -
+    PDC_get_window_pool         -       -       -
 
 **man-end****************************************************************/
 
 #include <stdlib.h>
+#include <string.h>
+
+static bool _damage_spans = FALSE;
+
+/* All of a window's memory comes from _alloc(), which puts a header
+   before each block giving its size class, or -1 if it's not to be
+   pooled. With the pool on, blocks are rounded up to their class, and
+   _release() keeps them in a list per class for reuse. */
+
+#define _POOL_MIN      64    /* size of the smallest class */
+#define _POOL_CLASSES  16    /* so the largest is 2 MB */
+
+typedef union _poolhead
+{
+    int size_class;
+    union _poolhead *next;   /* while in a free list */
+    double align;
+} _POOLHEAD;
+
+static bool _pool_on = FALSE;
+static _POOLHEAD *_pool[_POOL_CLASSES];
+static PDC_WINDOW_POOL _pool_stats;
+
+static int _size_class(size_t size)
+{
+    int c;
+
+    for (c = 0; c < _POOL_CLASSES; c++)
+        if (size <= (size_t)_POOL_MIN << c)
+            return c;
+
+    return -1;
+}
+
+static void _pool_put(_POOLHEAD *head, int c)
+{
+    head->next = _pool[c];
+    _pool[c] = head;
+
+    _pool_stats.cached++;
+    _pool_stats.cached_bytes += (size_t)_POOL_MIN << c;
+}
+
+static void *_alloc(size_t size)
+{
+    _POOLHEAD *head;
+    int c = _pool_on ? _size_class(size) : -1;
+
+    if (c != -1 && _pool[c])
+    {
+        head = _pool[c];
+        _pool[c] = head->next;
+
+        _pool_stats.cached--;
+        _pool_stats.cached_bytes -= (size_t)_POOL_MIN << c;
+        _pool_stats.hits++;
+    }
+    else
+    {
+        head = malloc(sizeof(_POOLHEAD) +
+                      (c == -1 ? size : (size_t)_POOL_MIN << c));
+        if (!head)
+            return NULL;
+
+        if (_pool_on)
+            _pool_stats.misses++;
+    }
+
+    head->size_class = c;
+    _pool_stats.in_use++;
+
+    return head + 1;
+}
+
+static void *_calloc(size_t size)
+{
+    void *p = _alloc(size);
+
+    if (p)
+        memset(p, 0, size);
+
+    return p;
+}
+
+static void _release(void *p)
+{
+    _POOLHEAD *head;
+
+    if (!p)
+        return;
+
+    head = (_POOLHEAD *)p - 1;
+    _pool_stats.in_use--;
+
+    if (_pool_on && head->size_class != -1)
+        _pool_put(head, head->size_class);
+    else
+        free(head);
+}
+
+/* grow a block to size, keeping the first keep bytes; on failure, the
+   old block is left alone */
+
+static void *_resize(void *p, size_t keep, size_t size)
+{
+    _POOLHEAD *head = (_POOLHEAD *)p - 1;
+    void *new;
+
+    if (head->size_class != -1 &&
+        size <= (size_t)_POOL_MIN << head->size_class)
+        return p;
+
+    if (!_pool_on && head->size_class == -1)
+    {
+        head = realloc(head, sizeof(_POOLHEAD) + size);
+
+        return head ? head + 1 : NULL;
+    }
+
+    new = _alloc(size);
+    if (new)
+    {
+        memcpy(new, p, keep);
+        _release(p);
+    }
+
+    return new;
+}
+
+/* A window's line pointers, dirty bitmap, change arrays and span lists
+   are allocated as one block, which _y points to. For a window with
+   lines of its own, PDC_makelines() extends the block to hold them,
+   back to back, each starting on a cache line. Lines may later be
+   rearranged (e.g. by wdeleteln()), but they stay in the block, so
+   freeing _y frees everything. */
+
+#define _LINE_ALIGN 64
+
+static size_t _head_size(int nlines, bool spans)
+{
+    size_t size = nlines * sizeof(chtype *) +
+                  PDC_DIRTY_WORDS(nlines) * sizeof(unsigned long) +
+                  nlines * 2 * sizeof(int);
+
+    if (spans)
+        size += nlines * PDC_SPAN_STRIDE * sizeof(int);
+
+    return size;
+}
+
+static size_t _line_size(int ncols)
+{
+    return (ncols * sizeof(chtype) + _LINE_ALIGN - 1) &
+           ~(size_t)(_LINE_ALIGN - 1);
+}
+
+static void _carve(WINDOW *win, char *block, int nlines, bool spans)
+{
+    win->_y = (chtype **)block;
+    win->_dirty = (unsigned long *)(win->_y + nlines);
+    win->_firstch = (int *)(win->_dirty + PDC_DIRTY_WORDS(nlines));
+    win->_lastch = win->_firstch + nlines;
+    win->_spans = spans ? win->_lastch + nlines : NULL;
+}
 
 WINDOW *PDC_makenew(int nlines, int ncols, int begy, int begx)
 {
     WINDOW *win;
+    char *block;
 
     PDC_LOG(("PDC_makenew() - called: lines %d cols %d begy %d begx %d\n",
              nlines, ncols, begy, begx));
 
     /* allocate the window structure itself */
 
-    win = calloc(1, sizeof(WINDOW));
+    win = _calloc(sizeof(WINDOW));
     if (!win)
         return win;
 
-    /* allocate the line pointer array */
+    /* allocate the line pointers, the dirty line bitmap, the minchng
+       and maxchng arrays, and the damage span lists, if wanted */
 
-    win->_y = malloc(nlines * sizeof(chtype *));
-    if (!win->_y)
+    block = _calloc(_head_size(nlines, _damage_spans));
+    if (!block)
     {
-        free(win);
+        _release(win);
         return (WINDOW *)NULL;
     }
 
-    /* allocate the minchng and maxchng arrays */
-
-    win->_firstch = malloc(nlines * sizeof(int));
-    if (!win->_firstch)
-    {
-        free(win->_y);
-        free(win);
-        return (WINDOW *)NULL;
-    }
-
-    win->_lastch = malloc(nlines * sizeof(int));
-    if (!win->_lastch)
-    {
-        free(win->_firstch);
-        free(win->_y);
-        free(win);
-        return (WINDOW *)NULL;
-    }
+    _carve(win, block, nlines, _damage_spans);
 
     /* initialize window variables */
 
@@ -197,7 +388,10 @@ WINDOW *PDC_makenew(int nlines, int ncols, int begy, int begx)
 
 WINDOW *PDC_makelines(WINDOW *win)
 {
-    int i, j, nlines, ncols;
+    int i, nlines;
+    size_t head, linesize;
+    bool spans;
+    char *block, *line;
 
     PDC_LOG(("PDC_makelines() - called\n"));
 
@@ -205,30 +399,246 @@ WINDOW *PDC_makelines(WINDOW *win)
         return (WINDOW *)NULL;
 
     nlines = win->_maxy;
-    ncols = win->_maxx;
+    spans = !!win->_spans;
+    head = _head_size(nlines, spans);
+    linesize = _line_size(win->_maxx);
 
-    for (i = 0; i < nlines; i++)
+    /* make room for the lines after the rest of the block */
+
+    block = _resize(win->_y, head,
+                    head + _LINE_ALIGN - 1 + nlines * linesize);
+    if (!block)
     {
-        win->_y[i] = malloc(ncols * sizeof(chtype));
-        if (!win->_y[i])
-        {
-            /* if error, free all the data */
+        _release(win->_y);
+        _release(win);
 
-            for (j = 0; j < i; j++)
-                free(win->_y[j]);
+        return (WINDOW *)NULL;
+    }
 
-            free(win->_firstch);
-            free(win->_lastch);
-            free(win->_y);
-            free(win);
+    _carve(win, block, nlines, spans);
 
-            return (WINDOW *)NULL;
-        }
+    line = block + head;
+    line += (_LINE_ALIGN - (size_t)line % _LINE_ALIGN) % _LINE_ALIGN;
+
+    for (i = 0; i < nlines; i++, line += linesize)
+        win->_y[i] = (chtype *)line;
+
+    return win;
+}
+
+/* A paged pad's block holds, after the usual arrays, a struct _pages,
+   the page table, and one blank line, which every line that hasn't
+   been written to points at. Lines are allocated from pages of
+   _PAGE_LINES slots; each slot starts with the number of its page, or
+   -1 if it's free, and a page is freed when its last line is. */
+
+#define _PAGE_LINES  64
+#define _SLOT_HEAD   16
+
+struct _pages
+{
+    chtype *blank;      /* the shared blank line */
+    char **page;        /* the pages, or NULL if not allocated */
+    int *used;          /* slots in use in each page */
+    int npages;
+    int next;           /* no page before this one has room */
+    size_t slotsize;
+};
+
+static struct _pages *_pages_of(WINDOW *win)
+{
+    size_t head = _head_size(win->_maxy, !!win->_spans);
+
+    head = (head + sizeof(double) - 1) / sizeof(double) * sizeof(double);
+
+    return (struct _pages *)((char *)win->_y + head);
+}
+
+WINDOW *PDC_makepages(WINDOW *win)
+{
+    struct _pages *pg;
+    int i, npages, nlines;
+    size_t head, size;
+    bool spans;
+    char *block, *p;
+    chtype *blank;
+
+    PDC_LOG(("PDC_makepages() - called\n"));
+
+    if (!win)
+        return (WINDOW *)NULL;
+
+    nlines = win->_maxy;
+    npages = (nlines + _PAGE_LINES - 1) / _PAGE_LINES;
+    spans = !!win->_spans;
+    head = _head_size(nlines, spans);
+
+    size = (head + sizeof(double) - 1) / sizeof(double) * sizeof(double) +
+           sizeof(struct _pages) + npages * (sizeof(char *) + sizeof(int)) +
+           _LINE_ALIGN - 1 + _line_size(win->_maxx);
+
+    block = _resize(win->_y, head, size);
+    if (!block)
+    {
+        _release(win->_y);
+        _release(win);
+
+        return (WINDOW *)NULL;
+    }
+
+    _carve(win, block, nlines, spans);
+
+    pg = _pages_of(win);
+    pg->page = (char **)(pg + 1);
+    pg->used = (int *)(pg->page + npages);
+    pg->npages = npages;
+    pg->next = 0;
+    pg->slotsize = _SLOT_HEAD + _line_size(win->_maxx);
+
+    p = (char *)(pg->used + npages);
+    p += (_LINE_ALIGN - (size_t)p % _LINE_ALIGN) % _LINE_ALIGN;
+    pg->blank = blank = (chtype *)p;
+
+    for (i = 0; i < win->_maxx; i++)
+        blank[i] = win->_bkgd;
+
+    for (i = 0; i < npages; i++)
+    {
+        pg->page[i] = NULL;
+        pg->used[i] = 0;
     }
 
+    for (i = 0; i < nlines; i++)
+        win->_y[i] = blank;
+
+    win->_flags |= _PAGED;
+
     return win;
 }
 
+static void _free_pages(WINDOW *win)
+{
+    struct _pages *pg = _pages_of(win);
+    int i;
+
+    for (i = 0; i < pg->npages; i++)
+        _release(pg->page[i]);
+}
+
+chtype *PDC_page_line(WINDOW *win, int y)
+{
+    struct _pages *pg = _pages_of(win);
+    char *slot;
+    int p, i;
+
+    if (win->_y[y] != pg->blank)
+        return win->_y[y];
+
+    /* take a free slot from the first page with room, allocating the
+       page if need be */
+
+    for (p = pg->next; p < pg->npages; p++)
+        if (pg->used[p] < _PAGE_LINES)
+            break;
+
+    if (p == pg->npages)
+        return NULL;
+
+    pg->next = p;
+
+    if (!pg->page[p])
+    {
+        pg->page[p] = _alloc(_PAGE_LINES * pg->slotsize);
+        if (!pg->page[p])
+            return NULL;
+
+        for (i = 0; i < _PAGE_LINES; i++)
+            *(int *)(pg->page[p] + i * pg->slotsize) = -1;
+    }
+
+    for (slot = pg->page[p]; *(int *)slot != -1; slot += pg->slotsize)
+        ;
+
+    *(int *)slot = p;
+    pg->used[p]++;
+
+    win->_y[y] = (chtype *)(slot + _SLOT_HEAD);
+    memcpy(win->_y[y], pg->blank, win->_maxx * sizeof(chtype));
+
+    return win->_y[y];
+}
+
+bool PDC_page_clear(WINDOW *win, int y, chtype blank)
+{
+    struct _pages *pg;
+    char *slot;
+    int p;
+
+    if (!(win->_flags & _PAGED))
+        return FALSE;
+
+    pg = _pages_of(win);
+
+    if (pg->blank[0] != blank)
+        return FALSE;
+
+    if (win->_y[y] == pg->blank)
+        return TRUE;
+
+    slot = (char *)win->_y[y] - _SLOT_HEAD;
+    p = *(int *)slot;
+
+    *(int *)slot = -1;
+    win->_y[y] = pg->blank;
+
+    if (!--pg->used[p])
+    {
+        _release(pg->page[p]);
+        pg->page[p] = NULL;
+    }
+
+    if (p < pg->next)
+        pg->next = p;
+
+    return TRUE;
+}
+
+chtype *PDC_blank_line(WINDOW *win)
+{
+    return (win->_flags & _PAGED) ? _pages_of(win)->blank : NULL;
+}
+
+/* give new, from PDC_makenew(), pages whose blank line is filled with
+   new->_bkgd, and copy the lines of the paged pad win into it -- only
+   the ones that have been written to, if the blank lines match */
+
+static WINDOW *_copy_pages(WINDOW *win, WINDOW *new)
+{
+    chtype *blank = PDC_blank_line(win);
+    bool same = (blank[0] == new->_bkgd);
+    int i, ncols = min(win->_maxx, new->_maxx);
+
+    new = PDC_makepages(new);
+    if (!new)
+        return (WINDOW *)NULL;
+
+    for (i = 0; i < win->_maxy && i < new->_maxy; i++)
+        if (win->_y[i] != blank || !same)
+        {
+            chtype *line = PDC_page_line(new, i);
+
+            if (!line)
+            {
+                delwin(new);
+                return (WINDOW *)NULL;
+            }
+
+            memcpy(line, win->_y[i], ncols * sizeof(chtype));
+        }
+
+    return new;
+}
+
 void PDC_sync(WINDOW *win)
 {
     PDC_LOG(("PDC_sync() - called:\n"));
@@ -266,24 +676,21 @@ WINDOW *newwin(int nlines, int ncols, int begy, int begx)
 
 int delwin(WINDOW *win)
 {
-    int i;
-
     PDC_LOG(("delwin() - called\n"));
 
     if (!win)
         return ERR;
 
-    /* subwindows use parents' lines */
+    /* subwindows use parents' lines; anything else has them in the
+       same block as the line pointers, in pages, or in a mapped file */
 
-    if (!(win->_flags & (_SUBWIN|_SUBPAD)))
-        for (i = 0; i < win->_maxy && win->_y[i]; i++)
-            if (win->_y[i])
-                free(win->_y[i]);
+    if (win->_flags & _PAGED)
+        _free_pages(win);
+    else if (win->_flags & _MAPPED)
+        PDC_unmap_pad(win);
 
-    free(win->_firstch);
-    free(win->_lastch);
-    free(win->_y);
-    free(win);
+    _release(win->_y);
+    _release(win);
 
     return OK;
 }
@@ -315,7 +722,8 @@ WINDOW *subwin(WINDOW *orig, int nlines, int ncols, int begy, int begx)
 
     /* make sure window fits inside the original one */
 
-    if (!orig || (begy < orig->_begy) || (begx < orig->_begx) ||
+    if (!orig || (orig->_flags & _PAGED) ||
+        (begy < orig->_begy) || (begx < orig->_begx) ||
         (begy + nlines) > (orig->_begy + orig->_maxy) ||
         (begx + ncols) > (orig->_begx + orig->_maxx))
         return (WINDOW *)NULL;
@@ -397,7 +805,12 @@ WINDOW *dupwin(WINDOW *win)
     begx = win->_begx;
 
     new = PDC_makenew(nlines, ncols, begy, begx);
-    if (new)
+    if (new && (win->_flags & _PAGED))
+    {
+        new->_bkgd = PDC_blank_line(win)[0];
+        new = _copy_pages(win, new);
+    }
+    else if (new)
         new = PDC_makelines(new);
 
     if (!new)
@@ -407,9 +820,10 @@ WINDOW *dupwin(WINDOW *win)
 
     for (i = 0; i < nlines; i++)
     {
-        for (ptr = new->_y[i], ptr1 = win->_y[i];
-             ptr < new->_y[i] + ncols; ptr++, ptr1++)
-            *ptr = *ptr1;
+        if (!(win->_flags & _PAGED))
+            for (ptr = new->_y[i], ptr1 = win->_y[i];
+                 ptr < new->_y[i] + ncols; ptr++, ptr1++)
+                *ptr = *ptr1;
 
         new->_firstch[i] = 0;
         new->_lastch[i] = ncols - 1;
@@ -421,7 +835,7 @@ WINDOW *dupwin(WINDOW *win)
     new->_maxx = win->_maxx;
     new->_begy = win->_begy;
     new->_begx = win->_begx;
-    new->_flags = win->_flags;
+    new->_flags = win->_flags & ~_MAPPED;
     new->_attrs = win->_attrs;
     new->_clear = win->_clear;
     new->_leaveit = win->_leaveit;
@@ -435,22 +849,82 @@ WINDOW *dupwin(WINDOW *win)
     new->_pary = win->_pary;
     new->_parent = win->_parent;
     new->_bkgd = win->_bkgd;
-    new->_flags = win->_flags;
+    new->_flags = win->_flags & ~_MAPPED;
 
     return new;
 }
 
+/* TRUE if line is one of those carved from win's own block */
+
+static bool _own_line(WINDOW *win, const chtype *line)
+{
+    const char *start = (const char *)win->_y +
+                        _head_size(win->_maxy, !!win->_spans);
+
+    return (const char *)line >= start &&
+           (const char *)line < start + _LINE_ALIGN - 1 +
+                                win->_maxy * _line_size(win->_maxx);
+}
+
+/* doupdate() trades whole lines between curscr and pdc_lastscr, so
+   either may hold lines from the other's block, which resizing or
+   freeing the other would pull out from under it. Give each its own
+   lines back, swapping the contents along with them so that neither
+   window changes. */
+
+static void _reclaim_lines(void)
+{
+    int i, j, x;
+
+    if (!curscr || !pdc_lastscr || curscr->_maxy != pdc_lastscr->_maxy ||
+        curscr->_maxx != pdc_lastscr->_maxx)
+        return;
+
+    for (i = j = 0; i < curscr->_maxy; i++)
+    {
+        chtype *line = curscr->_y[i], *other;
+
+        if (_own_line(curscr, line))
+            continue;
+
+        /* there are as many of curscr's lines in pdc_lastscr as there
+           are of pdc_lastscr's in curscr */
+
+        while (_own_line(pdc_lastscr, pdc_lastscr->_y[j]))
+            j++;
+
+        other = pdc_lastscr->_y[j];
+
+        for (x = 0; x < curscr->_maxx; x++)
+        {
+            chtype ch = line[x];
+
+            line[x] = other[x];
+            other[x] = ch;
+        }
+
+        curscr->_y[i] = other;
+        pdc_lastscr->_y[j] = line;
+    }
+}
+
 WINDOW *resize_window(WINDOW *win, int nlines, int ncols)
 {
     WINDOW *new;
-    int i, save_cury, save_curx, new_begy, new_begx;
+    int save_cury, save_curx, new_begy, new_begx;
 
     PDC_LOG(("resize_window() - called: nlines %d ncols %d\n",
              nlines, ncols));
 
-    if (!win)
+    if (!win || (win->_flags & _MAPPED))
         return (WINDOW *)NULL;
 
+    /* this holds whether resize_term() or the application resizes
+       curscr */
+
+    if (win == curscr || win == pdc_lastscr)
+        _reclaim_lines();
+
     if (win->_flags & _SUBPAD)
     {
         new = subpad(win->_parent, nlines, ncols, win->_begy, win->_begx);
@@ -484,7 +958,19 @@ WINDOW *resize_window(WINDOW *win, int nlines, int ncols)
     save_curx = min(win->_curx, (new->_maxx - 1));
     save_cury = min(win->_cury, (new->_maxy - 1));
 
-    if (!(win->_flags & (_SUBPAD|_SUBWIN)))
+    if (win->_flags & _PAGED)
+    {
+        /* the new lines share win's blank line, so what's beyond it is
+           filled with the pad's background too */
+
+        new->_bkgd = PDC_blank_line(win)[0];
+        new = _copy_pages(win, new);
+        if (!new)
+            return (WINDOW *)NULL;
+
+        _free_pages(win);
+    }
+    else if (!(win->_flags & (_SUBPAD|_SUBWIN)))
     {
         new = PDC_makelines(new);
         if (!new)
@@ -494,10 +980,6 @@ WINDOW *resize_window(WINDOW *win, int nlines, int ncols)
 
         copywin(win, new, 0, 0, 0, 0, min(win->_maxy, new->_maxy) - 1,
                 min(win->_maxx, new->_maxx) - 1, FALSE);
-
-        for (i = 0; i < win->_maxy && win->_y[i]; i++)
-            if (win->_y[i])
-                free(win->_y[i]);
     }
 
     new->_flags = win->_flags;
@@ -519,12 +1001,10 @@ WINDOW *resize_window(WINDOW *win, int nlines, int ncols)
     new->_curx = save_curx;
     new->_cury = save_cury;
 
-    free(win->_firstch);
-    free(win->_lastch);
-    free(win->_y);
+    _release(win->_y);
 
     *win = *new;
-    free(new);
+    _release(new);
 
     return win;
 }
@@ -581,3 +1061,92 @@ void wsyncdown(WINDOW *win)
         }
     }
 }
+
+int PDC_set_damage_spans(bool on)
+{
+    PDC_LOG(("PDC_set_damage_spans() - called: on %d\n", on));
+
+    _damage_spans = on;
+
+    return OK;
+}
+
+int PDC_set_window_pool(bool on)
+{
+    int c;
+
+    PDC_LOG(("PDC_set_window_pool() - called: on %d\n", on));
+
+    _pool_on = on;
+
+    if (!on)
+        for (c = 0; c < _POOL_CLASSES; c++)
+            while (_pool[c])
+            {
+                _POOLHEAD *head = _pool[c];
+
+                _pool[c] = head->next;
+                free(head);
+
+                _pool_stats.cached--;
+                _pool_stats.cached_bytes -= (size_t)_POOL_MIN << c;
+            }
+
+    return OK;
+}
+
+/* add a free block of at least size bytes to the pool */
+
+static int _reserve(size_t size)
+{
+    _POOLHEAD *head;
+    int c = _size_class(size);
+
+    if (c == -1)
+        return ERR;
+
+    head = malloc(sizeof(_POOLHEAD) + ((size_t)_POOL_MIN << c));
+    if (!head)
+        return ERR;
+
+    _pool_put(head, c);
+
+    return OK;
+}
+
+int PDC_reserve_windows(int count, int nlines, int ncols)
+{
+    size_t head;
+    int i;
+
+    PDC_LOG(("PDC_reserve_windows() - called: count %d lines %d cols %d\n",
+             count, nlines, ncols));
+
+    if (!_pool_on || count < 0 || nlines < 1 || ncols < 1)
+        return ERR;
+
+    head = _head_size(nlines, _damage_spans);
+
+    /* each window needs its structure and its block; a newwin() also
+       briefly holds a block without the lines */
+
+    for (i = 0; i < count; i++)
+        if (_reserve(sizeof(WINDOW)) == ERR || _reserve(head) == ERR ||
+            _reserve(head + _LINE_ALIGN - 1 +
+                     nlines * _line_size(ncols)) == ERR)
+            return ERR;
+
+    return OK;
+}
+
+int PDC_get_window_pool(PDC_WINDOW_POOL *stats)
+{
+    PDC_LOG(("PDC_get_window_pool() - called\n"));
+
+    if (!stats)
+        return ERR;
+
+    *stats = _pool_stats;
+
+    return OK;
+}
@@ -88,6 +88,9 @@ void PDC_update_rects(void)
         else
             SDL_UpdateRects(pdc_screen, rectcount, uprect);
 
+        PDC_STAT(presents, 1);
+        PDC_STAT(rects, rectcount);
+
         pdc_lastupdate = SDL_GetTicks();
         rectcount = 0;
     }
@@ -304,6 +307,25 @@ static void _highlight(SDL_Rect *src, SDL_Rect *dest, chtype ch)
     }
 }
 
+/* this port draws each run as it comes; see PDC_transform_line() */
+
+bool PDC_transform_frame(const FRAMERUN *runs, int count, int cury, int curx)
+{
+    PDC_LOG(("PDC_transform_frame() - called: %d runs\n", count));
+
+    return FALSE;
+}
+
+/* this port doesn't move screen contents; doupdate() redraws instead */
+
+bool PDC_scroll_region(int top, int bottom, int n)
+{
+    PDC_LOG(("PDC_scroll_region() - called: top %d bottom %d n %d\n",
+             top, bottom, n));
+
+    return FALSE;
+}
+
 /* update the given physical line to look like the corresponding line in
    curscr */
 
@@ -7,6 +7,18 @@ void PDC_beep(void)
     PDC_LOG(("PDC_beep() - called\n"));
 }
 
+unsigned long PDC_ms_count(void)
+{
+    return SDL_GetTicks();
+}
+
+unsigned long PDC_us_count(void)
+{
+    /* SDL 1.2 has no finer clock */
+
+    return SDL_GetTicks() * 1000UL;
+}
+
 void PDC_napms(int ms)
 {
     PDC_LOG(("PDC_napms() - called: ms=%d\n", ms));
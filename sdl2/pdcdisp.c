@@ -64,367 +64,1797 @@ chtype acs_map[128] =
 
 Uint32 pdc_lastupdate = 0;
 
-#define MAXRECT 200     /* maximum number of rects to queue up before
-                           an update is forced; the number was chosen
-                           arbitrarily */
-
-static SDL_Rect uprect[MAXRECT];       /* table of rects to update */
-static chtype oldch = (chtype) (-1);    /* current attribute */
-static int rectcount = 0;              /* index into uprect */
-static short foregr = -2, backgr = -2; /* current foreground, background */
+#define MAXRECT 200     /* maximum number of rects in one update; past
+                           that, the whole window is updated */
+
+#define RECTCOST 4096   /* the overhead of updating one more rect, in
+                           pixels' worth of copying; a guess */
+
+/* drawing state -- the main thread uses ren; in threaded mode, each
+   worker has its own (see PDC_transform_frame()) */
+
+struct render {
+    SDL_Surface *font;        /* copy of pdc_font, or NULL to use it */
+    SDL_Surface *screen;      /* alias of pdc_screen, or NULL */
+    SDL_Surface *back;        /* alias of pdc_tileback, or NULL */
+    chtype oldch;             /* current attribute */
+    short foregr, backgr;     /* current foreground, background */
+    Uint32 fgpix, bgpix;      /* the same, as pixel values */
+    bool damaged;             /* drawn on since the last update */
+#ifdef PDC_WIDE
+    int style;                /* TTF style of the current run */
+#else
+    short fontfg, fontbg;     /* colors set in the font's palette */
+#endif
+};
+
+#define FONT(r)   ((r)->font ? (r)->font : pdc_font)
+#define SCREEN(r) ((r)->screen ? (r)->screen : pdc_screen)
+#define BACK(r)   ((r)->back ? (r)->back : pdc_tileback)
+
+static SDL_Rect uprect[MAXRECT];
+static struct render ren = {NULL, NULL, NULL, (chtype) (-1), -2, -2,
+                             0, 0, FALSE,
+#ifdef PDC_WIDE
+                             0
+#else
+                             -2, -2
+#endif
+                            };
 static bool blinked_off = FALSE;
 
-/* do the real updates on a delay */
+/* What's been drawn since the last update is kept as a bitmap of
+   tiles: one 64-bit row per line of the screen, with each tile as many
+   cells wide as it takes to cover the line in 64 of them. At update
+   time, _damage_rects() turns it into rects. Set tiles close enough
+   together in a row make one span, and spans that line up exactly in
+   consecutive rows make one rect. Each rect costs RECTCOST on top of
+   its area; if the total reaches the cost of updating the whole
+   window, or there would be more than MAXRECT rects, the whole window
+   is updated instead. Workers only mark the lines of their own bands,
+   so no row is written by two threads. */
+
+static Uint64 *damage = NULL;
+static int damage_rows = 0, damage_cols = 0;
+static int tile_cells = 1;             /* cells per tile */
+static bool damage_all = FALSE;
+
+/* size the damage map to the screen, if it isn't already; when it
+   changes, everything is damaged. Only the main thread calls this, and
+   never while the workers are drawing. */
+
+static void _damage_ready(void) {
+    if (damage && damage_rows == SP->lines && damage_cols == SP->cols)
+        return;
 
-void PDC_update_rects(void) {
-    if (rectcount) {
-        /* if the maximum number of rects has been reached, we're
-           probably better off doing a full screen update */
+    free(damage);
 
-        if (rectcount == MAXRECT)
-            SDL_UpdateWindowSurface(pdc_window);
-        else
-            SDL_UpdateWindowSurfaceRects(pdc_window, uprect, rectcount);
+    damage = calloc(SP->lines, sizeof(Uint64));
+    damage_rows = damage ? SP->lines : 0;
+    damage_cols = SP->cols;
+    tile_cells = (SP->cols + 63) / 64;
+    damage_all = TRUE;
+    ren.damaged = TRUE;
+}
 
-        pdc_lastupdate = SDL_GetTicks();
-        rectcount = 0;
-    }
+/* mark len cells at (y, x) as drawn */
+
+static void _damage(struct render *r, int y, int x, int len) {
+    if (y < damage_rows && len > 0) {
+        int first = x / tile_cells, last = (x + len - 1) / tile_cells;
+
+        if (last > 63)
+            last = 63;
+
+        damage[y] |= (~(Uint64)0 >> (63 - last)) & (~(Uint64)0 << first);
+    } else
+        damage_all = TRUE;
+
+    r->damaged = TRUE;
 }
 
-/* set the font colors to match the chtype's attribute */
+/* turn the damage map into a list of rects in out, and clear it;
+   returns the number of rects, or -1 to update the whole window */
 
-static void _set_attr(chtype ch) {
-    attr_t sysattrs = SP->termattrs;
+static int _damage_rects(SDL_Rect *out) {
+    struct span {
+        int a, b;                      /* tiles a through b - 1 */
+        int y;                         /* first row */
+    } open[64], cur[64];
+    long cost = 0, full = (long)pdc_screen->w * pdc_screen->h + RECTCOST;
+    long tilearea = (long)tile_cells * pdc_fwidth * pdc_fheight;
+    int gap = (int)(RECTCOST / tilearea);
+    int nopen = 0, n = 0, y;
+    bool all = damage_all;
 
-    ch &= (A_COLOR | A_BOLD | A_BLINK | A_REVERSE);
+    for (y = 0; y <= damage_rows; y++) {
+        Uint64 bits = (y < damage_rows) ? damage[y] : 0;
+        int ncur = 0, i, j, t = 0;
 
-    if (oldch != ch) {
-        short newfg, newbg;
+        if (y < damage_rows)
+            damage[y] = 0;
 
-        if (SP->mono)
-            return;
+        /* runs of set tiles, with gaps too small to be worth another
+           rect filled in */
 
-        PDC_pair_content(PAIR_NUMBER(ch), &newfg, &newbg);
+        while (t < 64 && (bits >> t)) {
+            int a;
 
-        if ((ch & A_BOLD) && !(sysattrs & A_BOLD))
-            newfg |= 8;
-        if ((ch & A_BLINK) && !(sysattrs & A_BLINK))
-            newbg |= 8;
+            while (!(bits >> t & 1))
+                t++;
 
-        if (ch & A_REVERSE) {
-            short tmp = newfg;
-            newfg = newbg;
-            newbg = tmp;
-        }
+            a = t;
 
-        if (newfg != foregr) {
-#ifndef PDC_WIDE
-            SDL_SetPaletteColors(pdc_font->format->palette,
-                                 pdc_color + newfg, pdc_flastc, 1);
-#endif
-            foregr = newfg;
+            while (t < 64 && (bits >> t & 1))
+                t++;
+
+            if (ncur && a - cur[ncur - 1].b <= gap)
+                cur[ncur - 1].b = t;
+            else {
+                cur[ncur].a = a;
+                cur[ncur].b = t;
+                cur[ncur].y = y;
+                ncur++;
+            }
         }
 
-        if (newbg != backgr) {
-#ifndef PDC_WIDE
-            if (newbg == -1)
-                SDL_SetColorKey(pdc_font, SDL_TRUE, 0);
-            else
-            {
-                if (backgr == -1)
-                    SDL_SetColorKey(pdc_font, SDL_FALSE, 0);
-
-                SDL_SetPaletteColors(pdc_font->format->palette,
-                                     pdc_color + newbg, 0, 1);
+        /* a span that lines up with one above continues its rect;
+           rects that aren't continued are finished */
+
+        for (i = j = 0; i < nopen; i++) {
+            while (j < ncur && cur[j].a < open[i].a)
+                j++;
+
+            if (j < ncur && cur[j].a == open[i].a && cur[j].b == open[i].b)
+                cur[j].y = open[i].y;
+            else if (!all) {
+                int left = open[i].a * tile_cells;
+                int right = open[i].b * tile_cells;
+                SDL_Rect rect;
+
+                if (right > damage_cols)
+                    right = damage_cols;
+
+                rect.x = pdc_xoffset + left * pdc_fwidth;
+                rect.y = pdc_yoffset + open[i].y * pdc_fheight;
+                rect.w = (right - left) * pdc_fwidth;
+                rect.h = (y - open[i].y) * pdc_fheight;
+
+                cost += RECTCOST + (long)rect.w * rect.h;
+
+                if (n == MAXRECT || cost >= full)
+                    all = TRUE;
+                else
+                    out[n++] = rect;
             }
-#endif
-            backgr = newbg;
         }
 
-        oldch = ch;
+        memcpy(open, cur, ncur * sizeof(struct span));
+        nopen = ncur;
     }
+
+    damage_all = FALSE;
+
+    return all ? -1 : n;
 }
 
-/* draw a cursor at (y, x) */
+/* With pdc_async_present set, pdc_screen is a back surface, and
+   PDC_update_rects() hands each finished frame to a present thread,
+   which copies it to the window surface and updates the window. There
+   are three frame buffers: one being filled, one waiting in a
+   single-slot mailbox, and one being presented. If the waiting frame
+   hasn't been picked up by the time the next one is ready, it's
+   dropped, and its rects are passed along with the new one.
+
+   The mailbox is one atomic value, holding the number of the waiting
+   frame and that of the frame being presented, so that a frame moves
+   from one to the other in a single step. Only the application thread
+   puts a frame in; only the present thread takes one out. */
+
+#define NFRAMES 3
+
+struct frame {
+    SDL_Surface *surface;
+    SDL_Rect stale[MAXRECT];   /* changed since the buffer was filled */
+    int nstale;                /* -1 = everything */
+    SDL_Rect rects[MAXRECT];   /* to update in the window */
+    int nrects;                /* -1 = everything */
+};
+
+#define READY(m) (((m) & 15) - 1)
+#define BUSY(m) (((m) >> 4) - 1)
+#define MAIL(ready, busy) (((ready) + 1) | (((busy) + 1) << 4))
+
+static struct frame frames[NFRAMES];
+static SDL_Surface *window_surface = NULL;
+static SDL_Thread *presenter = NULL;
+static SDL_sem *present_go = NULL;
+static SDL_atomic_t mailbox;
+static bool present_quit = FALSE;
+
+/* copy the pixels in rect r (or all of them, if r is NULL) between
+   surfaces of the same size and format */
+
+static void _copy_rect(SDL_Surface *dst, SDL_Surface *src,
+                       const SDL_Rect *r) {
+    SDL_Rect full, clip;
+    int bpp = dst->format->BytesPerPixel, y;
+
+    full.x = full.y = 0;
+    full.w = dst->w;
+    full.h = dst->h;
+
+    if (!r)
+        clip = full;
+    else if (!SDL_IntersectRect(r, &full, &clip))
+        return;
 
-void PDC_gotoyx(int row, int col) {
-    SDL_Rect src, dest;
-    chtype ch;
-    int oldrow, oldcol;
-#ifdef PDC_WIDE
-    Uint16 chstr[2] = {0, 0};
-#endif
+    for (y = clip.y; y < clip.y + clip.h; y++)
+        memcpy((Uint8 *)dst->pixels + y * dst->pitch + clip.x * bpp,
+               (Uint8 *)src->pixels + y * src->pitch + clip.x * bpp,
+               clip.w * bpp);
+}
 
+/* add count rects (-1 = everything) to a list */
 
-    PDC_LOG(("PDC_gotoyx() - called: row %d col %d from row %d col %d\n",
-            row, col, SP->cursrow, SP->curscol));
+static void _add_rects(SDL_Rect *list, int *n, const SDL_Rect *rects,
+                       int count) {
+    if (*n == -1)
+        return;
 
-    if (SP->mono)
+    if (count == -1 || *n + count > MAXRECT) {
+        *n = -1;
         return;
+    }
 
-    oldrow = SP->cursrow;
-    oldcol = SP->curscol;
+    memcpy(list + *n, rects, count * sizeof(SDL_Rect));
+    *n += count;
+}
 
-    /* clear the old cursor */
+static int _presenter(void *data) {
+    for (;;) {
+        struct frame *fr;
+        int m, f;
 
-    PDC_transform_line(oldrow, oldcol, 1, curscr->_y[oldrow] + oldcol);
+        SDL_SemWait(present_go);
 
-    if (!SP->visibility)
-        return;
+        if (present_quit)
+            break;
 
-    /* draw a new cursor by overprinting the existing character in
-       reverse, either the full cell (when visibility == 2) or the
-       lowest quarter of it (when visibility == 1) */
+        do {
+            m = SDL_AtomicGet(&mailbox);
+            f = READY(m);
+        } while (f != -1 && !SDL_AtomicCAS(&mailbox, m, MAIL(-1, f)));
 
-    ch = curscr->_y[row][col] ^ A_REVERSE;
+        if (f == -1)
+            continue;
 
-    _set_attr(ch);
+        fr = frames + f;
 
-#ifdef CHTYPE_LONG
-    if (ch & A_ALTCHARSET && !(ch & 0xff80))
-        ch = acs_map[ch & 0x7f];
-#endif
-    src.h = (SP->visibility == 1) ? pdc_fheight >> 2 : pdc_fheight;
-    src.w = pdc_fwidth;
+        if (fr->nrects == -1) {
+            _copy_rect(window_surface, fr->surface, NULL);
+            SDL_UpdateWindowSurface(pdc_window);
+        } else {
+            int i;
 
-    dest.y = (row + 1) * pdc_fheight - src.h + pdc_yoffset;
-    dest.x = col * pdc_fwidth + pdc_xoffset;
+            for (i = 0; i < fr->nrects; i++)
+                _copy_rect(window_surface, fr->surface, fr->rects + i);
 
-#ifdef PDC_WIDE
-    chstr[0] = ch & A_CHARTEXT;
+            SDL_UpdateWindowSurfaceRects(pdc_window, fr->rects,
+                                         fr->nrects);
+        }
 
-    pdc_font = TTF_RenderUNICODE_Solid(pdc_ttffont, chstr, pdc_color[foregr]);
-    if (pdc_font) {
-        dest.h = src.h;
-        dest.w = src.w;
-        src.x = 0;
-        src.y = 0;
-        SDL_SetColorKey(pdc_font, SDL_FALSE, 0);
-        SDL_SetPaletteColors(pdc_font->format->palette,
-                             pdc_color + backgr, 0, 1);
-        SDL_BlitSurface(pdc_font, &src, pdc_screen, &dest);
-        SDL_FreeSurface(pdc_font);
-        pdc_font = NULL;
+        do
+            m = SDL_AtomicGet(&mailbox);
+        while (!SDL_AtomicCAS(&mailbox, m, MAIL(READY(m), -1)));
     }
-#else
 
-    src.x = (ch & 0xff) % 32 * pdc_fwidth;
-    src.y = (ch & 0xff) / 32 * pdc_fheight + (pdc_fheight - src.h);
+    return 0;
+}
+
+/* pass count rects (-1 = everything), drawn on pdc_screen, to the
+   present thread */
 
-    SDL_BlitSurface(pdc_font, &src, pdc_screen, &dest);
-#endif
+static void _publish(const SDL_Rect *rects, int count) {
+    struct frame *fr;
+    int m, f, busy, i;
+
+    /* take back a frame that's still waiting, if there is one */
+
+    do {
+        m = SDL_AtomicGet(&mailbox);
+        f = READY(m);
+    } while (f != -1 && !SDL_AtomicCAS(&mailbox, m, MAIL(-1, BUSY(m))));
+
+    busy = BUSY(SDL_AtomicGet(&mailbox));
+
+    /* the new rects are out of date in every buffer */
+
+    for (i = 0; i < NFRAMES; i++)
+        _add_rects(frames[i].stale, &frames[i].nstale, rects, count);
+
+    /* use the dropped frame, keeping its rects; otherwise, the free
+       buffer that's least out of date */
 
-    if (oldrow != row || oldcol != col) {
-        if (rectcount == MAXRECT)
-            PDC_update_rects();
+    if (f == -1) {
+        for (i = 0; i < NFRAMES; i++)
+            if (i != busy && (f == -1 || frames[f].nstale == -1 ||
+                (frames[i].nstale != -1 &&
+                 frames[i].nstale < frames[f].nstale)))
+                f = i;
 
-        uprect[rectcount++] = dest;
+        frames[f].nrects = 0;
     }
-}
 
-/* handle the A_*LINE attributes */
+    fr = frames + f;
 
-static void _highlight(SDL_Rect *src, SDL_Rect *dest, chtype ch) {
-    short col = SP->line_color;
-#ifdef PDC_WIDE
-    char chstr[2] = {'_', '\0'};
-#endif
+    _add_rects(fr->rects, &fr->nrects, rects, count);
 
-    if (SP->mono)
+    if (fr->nstale == -1)
+        _copy_rect(fr->surface, pdc_screen, NULL);
+    else
+        for (i = 0; i < fr->nstale; i++)
+            _copy_rect(fr->surface, pdc_screen, fr->stale + i);
+
+    fr->nstale = 0;
+
+    do
+        m = SDL_AtomicGet(&mailbox);
+    while (!SDL_AtomicCAS(&mailbox, m, MAIL(f, BUSY(m))));
+
+    SDL_SemPost(present_go);
+}
+
+static void _stop_presenter(void) {
+    int i;
+
+    if (!presenter)
         return;
 
-    if (ch & A_UNDERLINE) {
-#ifdef PDC_WIDE
-        if (col == -1)
-            col = foregr;
+    present_quit = TRUE;
+    SDL_SemPost(present_go);
+    SDL_WaitThread(presenter, NULL);
+    SDL_DestroySemaphore(present_go);
 
-        pdc_font = TTF_RenderText_Solid(pdc_ttffont, chstr, pdc_color[col]);
-        if (pdc_font) {
-            src->x = 0;
-            src->y = 0;
+    for (i = 0; i < NFRAMES; i++) {
+        SDL_FreeSurface(frames[i].surface);
+        frames[i].surface = NULL;
+    }
 
-            if (backgr != -1)
-                SDL_SetColorKey(pdc_font, SDL_TRUE, 0);
+    SDL_FreeSurface(pdc_screen);
+    pdc_screen = window_surface;
 
-            SDL_BlitSurface(pdc_font, src, pdc_screen, dest);
-            SDL_FreeSurface(pdc_font);
-            pdc_font = NULL;
-        }
-#else
-        if (col != -1)
-            SDL_SetPaletteColors(pdc_font->format->palette,
-                                 pdc_color + col, pdc_flastc, 1);
+    presenter = NULL;
+    present_go = NULL;
+    present_quit = FALSE;
+}
 
-        src->x = '_' % 32 * pdc_fwidth;
-        src->y = '_' / 32 * pdc_fheight;
+static SDL_Surface *_new_surface(SDL_Surface *like) {
+    SDL_PixelFormat *fmt = like->format;
 
-        if (backgr != -1)
-            SDL_SetColorKey(pdc_font, SDL_TRUE, 0);
+    return SDL_CreateRGBSurface(0, like->w, like->h, fmt->BitsPerPixel,
+                                fmt->Rmask, fmt->Gmask, fmt->Bmask,
+                                fmt->Amask);
+}
 
-        SDL_BlitSurface(pdc_font, src, pdc_screen, dest);
+static bool _start_presenter(void) {
+    int i;
 
-        if (backgr != -1)
-            SDL_SetColorKey(pdc_font, SDL_FALSE, 0);
+    pdc_screen = _new_surface(window_surface);
+    present_go = SDL_CreateSemaphore(0);
 
-        if (col != -1)
-            SDL_SetPaletteColors(pdc_font->format->palette,
-                                 pdc_color + foregr, pdc_flastc, 1);
-#endif
-    }
+    for (i = 0; i < NFRAMES; i++) {
+        frames[i].surface = _new_surface(window_surface);
+        frames[i].nstale = -1;
+        frames[i].nrects = 0;
 
-    if (ch & (A_LEFT | A_RIGHT)) {
-        if (col == -1)
-            col = foregr;
+        if (!frames[i].surface)
+            break;
+    }
 
-        dest->w = 1;
+    SDL_AtomicSet(&mailbox, MAIL(-1, -1));
 
-        if (ch & A_LEFT)
-            SDL_FillRect(pdc_screen, dest, pdc_mapped[col]);
+    if (i == NFRAMES && pdc_screen && present_go)
+        presenter = SDL_CreateThread(_presenter, "PDCurses present", NULL);
 
-        if (ch & A_RIGHT) {
-            dest->x += pdc_fwidth - 1;
-            SDL_FillRect(pdc_screen, dest, pdc_mapped[col]);
-            dest->x -= pdc_fwidth - 1;
+    if (!presenter) {
+        for (i = 0; i < NFRAMES; i++) {
+            SDL_FreeSurface(frames[i].surface);
+            frames[i].surface = NULL;
         }
 
-        dest->w = pdc_fwidth;
+        if (present_go)
+            SDL_DestroySemaphore(present_go);
+
+        SDL_FreeSurface(pdc_screen);
+        pdc_screen = window_surface;
+        present_go = NULL;
+
+        return FALSE;
     }
+
+    /* start from what's in the window */
+
+    _copy_rect(pdc_screen, window_surface, NULL);
+
+    return TRUE;
 }
 
-/* update the given physical line to look like the corresponding line in
-   curscr */
+/* stop the present thread, if it's running, before the window is
+   resized; SDL doesn't allow two threads into one window at once.
+   PDC_set_screen() starts it again. */
 
-void PDC_transform_line(int lineno, int x, int len, const chtype *srcp) {
-    SDL_Rect src, dest, lastrect;
-    int j;
-#ifdef PDC_WIDE
-    Uint16 chstr[2] = {0, 0};
-#endif
-    attr_t sysattrs = SP->termattrs;
+void PDC_stop_presenter(void) {
+    _stop_presenter();
+}
 
-    PDC_LOG(("PDC_transform_line() - called: lineno=%d\n", lineno));
+/* point pdc_screen at the window's surface -- or, with
+   pdc_async_present, at a back surface of the same size and format */
+
+void PDC_set_screen(void) {
+    _stop_presenter();
+
+    window_surface = pdc_screen = SDL_GetWindowSurface(pdc_window);
 
-    if (rectcount == MAXRECT)
+    if (pdc_async_present && pdc_screen && !SDL_MUSTLOCK(pdc_screen))
+        _start_presenter();
+}
+
+/* show the whole screen again, as after an expose event */
+
+void PDC_update_window(void) {
+    if (presenter) {
+        _damage_ready();
+        damage_all = ren.damaged = TRUE;
         PDC_update_rects();
+    } else
+        SDL_UpdateWindowSurface(pdc_window);
+}
 
-    src.h = pdc_fheight;
-    src.w = pdc_fwidth;
+/* do the real updates on a delay */
 
-    dest.y = pdc_fheight * lineno + pdc_yoffset;
-    dest.x = pdc_fwidth * x + pdc_xoffset;
-    dest.h = pdc_fheight;
-    dest.w = pdc_fwidth * len;
+void PDC_update_rects(void) {
+    if (ren.damaged) {
+        int count = _damage_rects(uprect);
 
-    /* if the previous rect was just above this one, with the same width
-       and horizontal position, then merge the new one with it instead
-       of adding a new entry */
+        if (presenter)
+            _publish(uprect, count);
+        else if (count == -1)
+            SDL_UpdateWindowSurface(pdc_window);
+        else if (count)
+            SDL_UpdateWindowSurfaceRects(pdc_window, uprect, count);
 
-    if (rectcount)
-        lastrect = uprect[rectcount - 1];
+        PDC_STAT(presents, 1);
+        PDC_STAT(rects, (count == -1) ? 1 : count);
 
-    if (rectcount && lastrect.x == dest.x && lastrect.w == dest.w) {
-        if (lastrect.y + lastrect.h == dest.y)
-            uprect[rectcount - 1].h = lastrect.h + pdc_fheight;
-        else if (lastrect.y != dest.y)
-            uprect[rectcount++] = dest;
-    } else
-        uprect[rectcount++] = dest;
+        pdc_lastupdate = SDL_GetTicks();
+        ren.damaged = FALSE;
+    }
+}
 
-    dest.w = pdc_fwidth;
+/* the colors for every combination of color pair, A_BOLD, A_BLINK and
+   A_REVERSE, kept up to date by PDC_cache_colors() */
 
-#ifdef PDC_WIDE
-    src.x = 0;
-    src.y = 0;
-#endif
+struct colors {
+    short fg, bg;
+    Uint32 fgpix, bgpix;      /* pdc_mapped[] of fg and bg */
+};
 
-    for (j = 0; j < len; j++) {
-        chtype ch = srcp[j];
+static struct colors coltab[PDC_COLOR_PAIRS << 3];
 
-        _set_attr(ch);
+#define COLKEY(ch) ((PAIR_NUMBER(ch) << 3) | (((ch) & A_BOLD) ? 4 : 0) | \
+                    (((ch) & A_BLINK) ? 2 : 0) | (((ch) & A_REVERSE) ? 1 : 0))
 
-        if (blinked_off && (ch & A_BLINK) && (sysattrs & A_BLINK))
-            ch = (ch & A_ATTRIBUTES) | ' ';
+/* look up the colors for the chtype's attribute */
 
-#ifdef CHTYPE_LONG
-        if (ch & A_ALTCHARSET && !(ch & 0xff80))
-            ch = (ch & (A_ATTRIBUTES ^ A_ALTCHARSET)) | acs_map[ch & 0x7f];
-#endif
-        if (backgr == -1)
-            SDL_LowerBlit(pdc_tileback, &dest, pdc_screen, &dest);
+static void _set_attr(struct render *r, chtype ch) {
+    ch &= (A_COLOR | A_BOLD | A_BLINK | A_REVERSE);
+
+    if (r->oldch != ch) {
+        const struct colors *c;
+
+        if (SP->mono)
+            return;
+
+        c = coltab + COLKEY(ch);
+
+        r->foregr = c->fg;
+        r->backgr = c->bg;
+        r->fgpix = c->fgpix;
+        r->bgpix = c->bgpix;
+        r->oldch = ch;
+    }
+}
 
 #ifdef PDC_WIDE
-        chstr[0] = ch & A_CHARTEXT;
-
-        TTF_SetFontStyle(pdc_ttffont,
-                         (((ch & A_BOLD) && (sysattrs & A_BOLD)) ?
-                          TTF_STYLE_BOLD : 0) |
-                         (((ch & A_ITALIC) && (sysattrs & A_ITALIC)) ?
-                          TTF_STYLE_ITALIC : 0));
-
-        pdc_font = TTF_RenderUNICODE_Solid(pdc_ttffont, chstr,
-                                           pdc_color[foregr]);
-
-        if (pdc_font) {
-            if (backgr != -1) {
-                SDL_SetColorKey(pdc_font, SDL_FALSE, 0);
-                SDL_SetPaletteColors(pdc_font->format->palette,
-                                     pdc_color + backgr, 0, 1);
-            }
-            SDL_BlitSurface(pdc_font, &src, pdc_screen, &dest);
-            SDL_FreeSurface(pdc_font);
-            pdc_font = NULL;
+
+/* In wide mode, glyphs are rendered by SDL_ttf once, into an atlas:
+   a set of 8-bit surfaces (pages) laid out as grids of cells, each of
+   which holds one glyph, keyed by its code and TTF style. Like the
+   narrow-mode font, the pages use palette color 1 for the foreground
+   and 0 for the background, so a glyph can be drawn in any colors.
+   Pages are added as needed, up to GLYPH_PAGES; after that, the least
+   recently used glyph gives up its cell. */
+
+#define GLYPH_COLS  32
+#define GLYPH_ROWS  32
+#define GLYPH_PAGES 8
+#define GLYPH_CELLS (GLYPH_COLS * GLYPH_ROWS)
+#define GLYPH_SLOTS (GLYPH_CELLS * GLYPH_PAGES)
+#define GLYPH_HASH  4096         /* must be a power of two */
+
+struct glyph {
+    Uint32 key;                  /* style << 16 | code */
+    int hnext;                   /* next in its hash chain, or -1 */
+    int older, newer;            /* neighbors in the LRU list, or -1 */
+};
+
+static struct glyph glyphs[GLYPH_SLOTS];
+static int glyph_hash[GLYPH_HASH];
+static int glyphs_used = 0;            /* slots handed out so far */
+static int glyph_newest = -1, glyph_oldest = -1;
+static bool glyphs_ready = FALSE;
+
+static struct {
+    SDL_Surface *surface;
+    short fg, bg;                      /* current palette colors */
+} glyph_page[GLYPH_PAGES];
+
+#define GLYPH_BUCKET(key) ((((key) >> 16) * 31 + (key)) & (GLYPH_HASH - 1))
+
+static void _glyph_unlink(int slot) {
+    struct glyph *g = glyphs + slot;
+
+    if (g->older != -1)
+        glyphs[g->older].newer = g->newer;
+    else
+        glyph_oldest = g->newer;
+
+    if (g->newer != -1)
+        glyphs[g->newer].older = g->older;
+    else
+        glyph_newest = g->older;
+}
+
+static void _glyph_touch(int slot) {
+    struct glyph *g = glyphs + slot;
+
+    g->older = glyph_newest;
+    g->newer = -1;
+
+    if (glyph_newest != -1)
+        glyphs[glyph_newest].newer = slot;
+    else
+        glyph_oldest = slot;
+
+    glyph_newest = slot;
+}
+
+/* take a cell for a new glyph: a fresh one, or the least recently used,
+   which is dropped from its hash chain */
+
+static int _glyph_slot(void) {
+    int slot, *p;
+
+    if (glyphs_used < GLYPH_SLOTS) {
+        int page = glyphs_used / GLYPH_CELLS;
+
+        if (!glyph_page[page].surface) {
+            glyph_page[page].surface = SDL_CreateRGBSurface(0,
+                GLYPH_COLS * pdc_fwidth, GLYPH_ROWS * pdc_fheight,
+                8, 0, 0, 0, 0);
+
+            if (!glyph_page[page].surface)
+                return -1;
+
+            glyph_page[page].fg = glyph_page[page].bg = -2;
         }
-#else
-        src.x = (ch & 0xff) % 32 * pdc_fwidth;
-        src.y = (ch & 0xff) / 32 * pdc_fheight;
 
-        SDL_LowerBlit(pdc_font, &src, pdc_screen, &dest);
-#endif
+        return glyphs_used++;
+    }
+
+    slot = glyph_oldest;
+
+    _glyph_unlink(slot);
+
+    for (p = glyph_hash + GLYPH_BUCKET(glyphs[slot].key); *p != slot;
+         p = &glyphs[*p].hnext)
+        ;
+
+    *p = glyphs[slot].hnext;
+
+    return slot;
+}
+
+/* render a glyph into its cell, cropped to the cell size, as the old
+   code did when blitting directly */
 
-        if (!(blinked_off && (ch & A_BLINK) && (sysattrs & A_BLINK)) &&
-            (ch & (A_UNDERLINE | A_LEFT | A_RIGHT)))
-            _highlight(&src, &dest, ch);
+static void _glyph_render(int slot, Uint16 code, int style) {
+    SDL_Surface *page = glyph_page[slot / GLYPH_CELLS].surface;
+    SDL_Surface *s;
+    SDL_Rect cell;
+    Uint16 chstr[2];
 
-        dest.x += pdc_fwidth;
+    cell.x = (slot % GLYPH_CELLS) % GLYPH_COLS * pdc_fwidth;
+    cell.y = (slot % GLYPH_CELLS) / GLYPH_COLS * pdc_fheight;
+    cell.w = pdc_fwidth;
+    cell.h = pdc_fheight;
+
+    SDL_FillRect(page, &cell, 0);
+
+    /* changing the style flushes SDL_ttf's own cache, so it's only
+       done when it has to be */
+
+    if (TTF_GetFontStyle(pdc_ttffont) != style)
+        TTF_SetFontStyle(pdc_ttffont, style);
+
+    chstr[0] = code;
+    chstr[1] = 0;
+
+    s = TTF_RenderUNICODE_Solid(pdc_ttffont, chstr, pdc_color[15]);
+    if (!s)
+        return;
+
+    if ((!SDL_MUSTLOCK(s) || SDL_LockSurface(s) == 0)) {
+        if (!SDL_MUSTLOCK(page) || SDL_LockSurface(page) == 0) {
+            int y, w = (s->w < cell.w) ? s->w : cell.w;
+            int h = (s->h < cell.h) ? s->h : cell.h;
+
+            for (y = 0; y < h; y++)
+                memcpy((Uint8 *)page->pixels + (cell.y + y) * page->pitch +
+                       cell.x, (Uint8 *)s->pixels + y * s->pitch, w);
+
+            if (SDL_MUSTLOCK(page))
+                SDL_UnlockSurface(page);
+        }
+
+        if (SDL_MUSTLOCK(s))
+            SDL_UnlockSurface(s);
     }
+
+    SDL_FreeSurface(s);
 }
 
-static Uint32 _blink_timer(Uint32 interval, void *param) {
-    SDL_Event event;
+/* find (or make) the glyph for code in the given style; returns the
+   index of its page (or -1), and sets the position of its cell in src */
 
-    event.type = SDL_USEREVENT;
-    SDL_PushEvent(&event);
-    return (interval);
+static int _glyph(Uint16 code, int style, SDL_Rect *src) {
+    Uint32 key = ((Uint32)style << 16) | code;
+    int slot, bucket = GLYPH_BUCKET(key);
+
+    if (!glyphs_ready) {
+        for (slot = 0; slot < GLYPH_HASH; slot++)
+            glyph_hash[slot] = -1;
+
+        glyphs_ready = TRUE;
+    }
+
+    for (slot = glyph_hash[bucket]; slot != -1; slot = glyphs[slot].hnext)
+        if (glyphs[slot].key == key)
+            break;
+
+    if (slot != -1) {
+        if (slot != glyph_newest) {
+            _glyph_unlink(slot);
+            _glyph_touch(slot);
+        }
+    } else {
+        slot = _glyph_slot();
+        if (slot == -1)
+            return -1;
+
+        glyphs[slot].key = key;
+        glyphs[slot].hnext = glyph_hash[bucket];
+        glyph_hash[bucket] = slot;
+
+        _glyph_touch(slot);
+        _glyph_render(slot, code, style);
+    }
+
+    src->x = (slot % GLYPH_CELLS) % GLYPH_COLS * pdc_fwidth;
+    src->y = (slot % GLYPH_CELLS) / GLYPH_COLS * pdc_fheight;
+    src->w = pdc_fwidth;
+    src->h = pdc_fheight;
+
+    return slot / GLYPH_CELLS;
 }
 
-void PDC_blink_text(void) {
-    static SDL_TimerID blinker_id = 0;
-    int i, j, k;
+/* draw rows top through top + h - 1 of a glyph at dest, in colors fg
+   and bg; a bg of -1 leaves the background showing through */
 
-    oldch = (chtype) (-1);
+static void _draw_glyph(Uint16 code, int style, short fg, short bg,
+                        int top, int h, SDL_Surface *screen,
+                        const SDL_Rect *dest) {
+    SDL_Rect src, d = *dest;
+    SDL_Surface *page;
+    int p = _glyph(code, style, &src);
 
-    if (!(SP->termattrs & A_BLINK)) {
-        SDL_RemoveTimer(blinker_id);
-        blinker_id = 0;
-    } else if (!blinker_id) {
-        blinker_id = SDL_AddTimer(500, _blink_timer, NULL);
-        blinked_off = TRUE;
+    if (p == -1)
+        return;
+
+    page = glyph_page[p].surface;
+
+    if (glyph_page[p].fg != fg) {
+        SDL_SetPaletteColors(page->format->palette, pdc_color + fg, 1, 1);
+        glyph_page[p].fg = fg;
     }
 
-    blinked_off = !blinked_off;
+    if (glyph_page[p].bg != bg) {
+        if (bg == -1)
+            SDL_SetColorKey(page, SDL_TRUE, 0);
+        else {
+            if (glyph_page[p].bg == -1 || glyph_page[p].bg == -2)
+                SDL_SetColorKey(page, SDL_FALSE, 0);
 
-    for (i = 0; i < SP->lines; i++) {
-        const chtype *srcp = curscr->_y[i];
+            SDL_SetPaletteColors(page->format->palette, pdc_color + bg,
+                                 0, 1);
+        }
 
-        for (j = 0; j < SP->cols; j++)
-            if (srcp[j] & A_BLINK) {
-                k = j;
-                while (k < SP->cols && (srcp[k] & A_BLINK))
-                    k++;
-                PDC_transform_line(i, j, k - j, srcp + j);
-                j = k;
-            }
+        glyph_page[p].bg = bg;
+    }
+
+    src.y += top;
+    src.h = h;
+
+    SDL_BlitSurface(page, &src, screen, &d);
+}
+
+void PDC_free_glyphs(void) {
+    int i;
+
+    for (i = 0; i < GLYPH_PAGES; i++) {
+        SDL_FreeSurface(glyph_page[i].surface);
+        glyph_page[i].surface = NULL;
     }
 
-    oldch = (chtype) (-1);
+    glyphs_used = 0;
+    glyph_newest = glyph_oldest = -1;
+    glyphs_ready = FALSE;
+}
+
+/* the TTF style for a cell's attributes */
+
+static int _glyph_style(chtype ch) {
+    attr_t sysattrs = SP->termattrs;
+
+    return (((ch & A_BOLD) && (sysattrs & A_BOLD)) ? TTF_STYLE_BOLD : 0) |
+           (((ch & A_ITALIC) && (sysattrs & A_ITALIC)) ?
+            TTF_STYLE_ITALIC : 0);
+}
+
+#else
+
+/* In narrow mode, when the surface being drawn on has 32-bit pixels,
+   cells are drawn straight into it: glyph_bits holds a copy of the
+   font with one bit per pixel, made once at startup, and each row of a
+   cell is expanded from it with the pixel values for its colors. The
+   text and any underline or side lines go down in one pass. Otherwise,
+   cells are blitted from pdc_font, and only then is its palette set up
+   for them, by _font_colors(). */
+
+# if defined(__SSE2__) || defined(_M_X64) || \
+     (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define PDC_RASTER_SSE2
+#  include <emmintrin.h>
+# elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#  define PDC_RASTER_NEON
+#  include <arm_neon.h>
+# endif
+
+static Uint32 *glyph_bits = NULL;      /* pdc_fheight rows per glyph;
+                                          bit x is pixel x */
+
+struct pens {
+    Uint32 fg, bg, line;               /* pixel values */
+    bool opaque;                       /* FALSE to keep the background */
+};
+
+/* make glyph_bits from pdc_font; it's left NULL if the font can't be
+   represented that way, and everything is then blitted */
+
+void PDC_load_glyphs(void) {
+    SDL_Surface *f = pdc_font;
+    bool ok = TRUE;
+    int c, x, y;
+
+    PDC_free_glyphs();
+
+    if (SP->mono || pdc_flastc < 1 || pdc_fwidth > 32 ||
+        f->format->BytesPerPixel != 1)
+        return;
+
+    glyph_bits = calloc(256 * pdc_fheight, sizeof(Uint32));
+    if (!glyph_bits)
+        return;
+
+    if (SDL_MUSTLOCK(f) && SDL_LockSurface(f) != 0) {
+        PDC_free_glyphs();
+        return;
+    }
+
+    for (c = 0; c < 256 && ok; c++)
+        for (y = 0; y < pdc_fheight; y++) {
+            const Uint8 *p = (const Uint8 *)f->pixels +
+                             (c / 32 * pdc_fheight + y) * f->pitch +
+                             c % 32 * pdc_fwidth;
+            Uint32 bits = 0;
+
+            /* only the two colors that _font_colors() sets can be
+               reproduced */
+
+            for (x = 0; x < pdc_fwidth; x++)
+                if (p[x] == pdc_flastc)
+                    bits |= (Uint32)1 << x;
+                else if (p[x])
+                    ok = FALSE;
+
+            glyph_bits[c * pdc_fheight + y] = bits;
+        }
+
+    if (SDL_MUSTLOCK(f))
+        SDL_UnlockSurface(f);
+
+    if (!ok)
+        PDC_free_glyphs();
+}
+
+void PDC_free_glyphs(void) {
+    free(glyph_bits);
+    glyph_bits = NULL;
+}
+
+/* set the palette of r's font for blitting in colors fg and bg; a bg
+   of -1 leaves the background showing through */
+
+static void _font_colors(struct render *r, short fg, short bg) {
+    if (SP->mono)
+        return;
+
+    if (fg != r->fontfg) {
+        SDL_SetPaletteColors(FONT(r)->format->palette, pdc_color + fg,
+                             pdc_flastc, 1);
+        r->fontfg = fg;
+    }
+
+    if (bg != r->fontbg) {
+        if (bg == -1)
+            SDL_SetColorKey(FONT(r), SDL_TRUE, 0);
+        else {
+            if (r->fontbg < 0)
+                SDL_SetColorKey(FONT(r), SDL_FALSE, 0);
+
+            SDL_SetPaletteColors(FONT(r)->format->palette,
+                                 pdc_color + bg, 0, 1);
+        }
+
+        r->fontbg = bg;
+    }
+}
+
+/* TRUE if len cells at (x, y) can be drawn straight into r's screen */
+
+static bool _direct(struct render *r, int x, int y, int len) {
+    SDL_Surface *s = SCREEN(r);
+
+    return glyph_bits && s->format->BytesPerPixel == 4 &&
+           !SDL_MUSTLOCK(s) && x >= 0 && y >= 0 &&
+           x + len * pdc_fwidth <= s->w && y + pdc_fheight <= s->h;
+}
+
+/* the pixel values for r's current colors */
+
+static void _pens(const struct render *r, struct pens *p) {
+    short col = SP->line_color;
+
+    p->fg = r->fgpix;
+    p->bg = r->bgpix;
+    p->line = (col == -1) ? r->fgpix : pdc_mapped[col];
+    p->opaque = (r->backgr != -1);
+}
+
+/* draw one row of a cell, w pixels wide: pixels set in bits get the
+   foreground, then those set in line get the line color */
+
+static void _raster_row(Uint32 *dst, int w, Uint32 bits, Uint32 line,
+                        const struct pens *p) {
+    int x = 0;
+
+#if defined(PDC_RASTER_SSE2)
+    const __m128i lanes = _mm_setr_epi32(1, 2, 4, 8);
+    const __m128i fg = _mm_set1_epi32((int)p->fg);
+    const __m128i bg = _mm_set1_epi32((int)p->bg);
+    const __m128i ln = _mm_set1_epi32((int)p->line);
+
+    for (; x + 4 <= w; x += 4) {
+        __m128i *q = (__m128i *)(dst + x);
+        __m128i out = p->opaque ? bg : _mm_loadu_si128(q);
+        __m128i m;
+
+        m = _mm_and_si128(_mm_set1_epi32((int)(bits >> x & 15)), lanes);
+        m = _mm_cmpeq_epi32(m, lanes);
+        out = _mm_or_si128(_mm_and_si128(m, fg), _mm_andnot_si128(m, out));
+
+        m = _mm_and_si128(_mm_set1_epi32((int)(line >> x & 15)), lanes);
+        m = _mm_cmpeq_epi32(m, lanes);
+        out = _mm_or_si128(_mm_and_si128(m, ln), _mm_andnot_si128(m, out));
+
+        _mm_storeu_si128(q, out);
+    }
+#elif defined(PDC_RASTER_NEON)
+    static const uint32_t bit[4] = {1, 2, 4, 8};
+    const uint32x4_t lanes = vld1q_u32(bit);
+    const uint32x4_t fg = vdupq_n_u32(p->fg);
+    const uint32x4_t bg = vdupq_n_u32(p->bg);
+    const uint32x4_t ln = vdupq_n_u32(p->line);
+
+    for (; x + 4 <= w; x += 4) {
+        uint32x4_t out = p->opaque ? bg : vld1q_u32(dst + x);
+
+        out = vbslq_u32(vtstq_u32(vdupq_n_u32(bits >> x & 15), lanes),
+                        fg, out);
+        out = vbslq_u32(vtstq_u32(vdupq_n_u32(line >> x & 15), lanes),
+                        ln, out);
+
+        vst1q_u32(dst + x, out);
+    }
+#endif
+
+    for (; x < w; x++)
+        if (line >> x & 1)
+            dst[x] = p->line;
+        else if (bits >> x & 1)
+            dst[x] = p->fg;
+        else if (p->opaque)
+            dst[x] = p->bg;
+}
+
+/* draw rows top through top + h - 1 of the cell for ch, whose top left
+   corner is at (x, y) in s */
+
+static void _raster_cell(SDL_Surface *s, int x, int y, chtype ch,
+                         int top, int h, const struct pens *p) {
+    const Uint32 *bits = glyph_bits + (ch & 0xff) * pdc_fheight;
+    const Uint32 *under = glyph_bits + '_' * pdc_fheight;
+    Uint8 *row = (Uint8 *)s->pixels + (y + top) * s->pitch + x * 4;
+    Uint32 edge = 0;
+    int i;
+
+    if (ch & A_LEFT)
+        edge |= 1;
+    if (ch & A_RIGHT)
+        edge |= (Uint32)1 << (pdc_fwidth - 1);
+
+    for (i = top; i < top + h; i++, row += s->pitch)
+        _raster_row((Uint32 *)row, pdc_fwidth, bits[i],
+                    edge | ((ch & A_UNDERLINE) ? under[i] : 0), p);
+}
+
+#endif
+
+/* fill in coltab for the given color pair, or for all of them if pair
+   is -1; called whenever the colors for an attribute could change */
+
+void PDC_cache_colors(int pair) {
+    attr_t sysattrs = SP->termattrs;
+    int i, first = 0, last = PDC_COLOR_PAIRS - 1;
+
+    if (pair >= 0)
+        first = last = pair;
+
+    for (i = first << 3; i < (last + 1) << 3; i++) {
+        struct colors *c = coltab + i;
+        short fg, bg;
+
+        PDC_pair_content(i >> 3, &fg, &bg);
+
+        if ((i & 4) && !(sysattrs & A_BOLD))
+            fg |= 8;
+        if ((i & 2) && !(sysattrs & A_BLINK))
+            bg |= 8;
+
+        c->fg = (i & 1) ? bg : fg;
+        c->bg = (i & 1) ? fg : bg;
+        c->fgpix = (c->fg < 0) ? 0 : pdc_mapped[c->fg];
+        c->bgpix = (c->bg < 0) ? 0 : pdc_mapped[c->bg];
+    }
+
+    ren.oldch = (chtype) (-1);
+
+    /* the values behind the color numbers may have changed, so the
+       palettes have to be set again */
+
+    if (pair < 0) {
+#ifdef PDC_WIDE
+        for (i = 0; i < GLYPH_PAGES; i++)
+            glyph_page[i].fg = glyph_page[i].bg = -2;
+#else
+        ren.fontfg = ren.fontbg = -2;
+#endif
+    }
+}
+
+/* draw a cursor at (y, x) */
+
+void PDC_gotoyx(int row, int col) {
+    SDL_Rect src, dest;
+    chtype ch;
+    int oldrow, oldcol;
+
+    PDC_LOG(("PDC_gotoyx() - called: row %d col %d from row %d col %d\n",
+            row, col, SP->cursrow, SP->curscol));
+
+    if (SP->mono)
+        return;
+
+    oldrow = SP->cursrow;
+    oldcol = SP->curscol;
+
+    /* clear the old cursor */
+
+    PDC_transform_line(oldrow, oldcol, 1, curscr->_y[oldrow] + oldcol);
+
+    if (!SP->visibility)
+        return;
+
+    /* draw a new cursor by overprinting the existing character in
+       reverse, either the full cell (when visibility == 2) or the
+       lowest quarter of it (when visibility == 1) */
+
+    ch = curscr->_y[row][col] ^ A_REVERSE;
+
+    _set_attr(&ren, ch);
+
+#ifdef CHTYPE_LONG
+    if (ch & A_ALTCHARSET && !(ch & 0xff80))
+        ch = acs_map[ch & 0x7f];
+#endif
+    src.h = (SP->visibility == 1) ? pdc_fheight >> 2 : pdc_fheight;
+    src.w = pdc_fwidth;
+
+    dest.y = (row + 1) * pdc_fheight - src.h + pdc_yoffset;
+    dest.x = col * pdc_fwidth + pdc_xoffset;
+
+#ifdef PDC_WIDE
+    dest.h = src.h;
+    dest.w = src.w;
+
+    _draw_glyph(ch & A_CHARTEXT, _glyph_style(ch), ren.foregr, ren.backgr,
+                pdc_fheight - src.h, src.h, pdc_screen, &dest);
+#else
+    if (_direct(&ren, dest.x, dest.y - (pdc_fheight - src.h), 1)) {
+        struct pens p;
+
+        dest.h = src.h;
+        dest.w = src.w;
+
+        _pens(&ren, &p);
+        _raster_cell(pdc_screen, dest.x, dest.y - (pdc_fheight - src.h),
+                     ch & 0xff, pdc_fheight - src.h, src.h, &p);
+    } else {
+        src.x = (ch & 0xff) % 32 * pdc_fwidth;
+        src.y = (ch & 0xff) / 32 * pdc_fheight + (pdc_fheight - src.h);
+
+        _font_colors(&ren, ren.foregr, ren.backgr);
+        SDL_BlitSurface(pdc_font, &src, pdc_screen, &dest);
+    }
+#endif
+
+    if (oldrow != row || oldcol != col)
+        _damage(&ren, row, col, 1);
+}
+
+/* handle the A_*LINE attributes */
+
+static void _highlight(struct render *r, SDL_Rect *src, SDL_Rect *dest,
+                       chtype ch) {
+    short col = SP->line_color;
+
+    if (SP->mono)
+        return;
+
+    if (ch & A_UNDERLINE) {
+#ifdef PDC_WIDE
+        if (col == -1)
+            col = r->foregr;
+
+        _draw_glyph('_', r->style, col, -1, 0, pdc_fheight,
+                    SCREEN(r), dest);
+#else
+        src->x = '_' % 32 * pdc_fwidth;
+        src->y = '_' / 32 * pdc_fheight;
+
+        _font_colors(r, (col == -1) ? r->foregr : col, -1);
+        SDL_BlitSurface(FONT(r), src, SCREEN(r), dest);
+#endif
+    }
+
+    if (ch & (A_LEFT | A_RIGHT)) {
+        if (col == -1)
+            col = r->foregr;
+
+        dest->w = 1;
+
+        if (ch & A_LEFT)
+            SDL_FillRect(SCREEN(r), dest, pdc_mapped[col]);
+
+        if (ch & A_RIGHT) {
+            dest->x += pdc_fwidth - 1;
+            SDL_FillRect(SCREEN(r), dest, pdc_mapped[col]);
+            dest->x -= pdc_fwidth - 1;
+        }
+
+        dest->w = pdc_fwidth;
+    }
+}
+
+/* draw len cells from srcp at (lineno, x), using the drawing state in
+   r, and mark them in the damage map */
+
+static void _draw_line(struct render *r, int lineno, int x, int len,
+                       const chtype *srcp) {
+    SDL_Rect src, dest;
+    int j, run;
+    attr_t sysattrs = SP->termattrs;
+#ifndef PDC_WIDE
+    struct pens pens;
+    bool direct;
+#endif
+
+    src.h = pdc_fheight;
+    src.w = pdc_fwidth;
+
+    dest.y = pdc_fheight * lineno + pdc_yoffset;
+    dest.x = pdc_fwidth * x + pdc_xoffset;
+    dest.h = pdc_fheight;
+    dest.w = pdc_fwidth;
+
+    _damage(r, lineno, x, len);
+
+#ifndef PDC_WIDE
+    direct = _direct(r, dest.x, dest.y, len);
+#endif
+
+    /* the attributes are looked at once per run of cells that share
+       them, rather than for every cell */
+
+    for (j = 0; j < len; j += run) {
+        attr_t attr = srcp[j] & A_ATTRIBUTES;
+        bool blank = blinked_off && (attr & A_BLINK) &&
+                     (sysattrs & A_BLINK);
+        int k;
+
+        run = PDC_attr_run(srcp + j, len - j, A_ATTRIBUTES);
+
+        _set_attr(r, attr);
+
+#ifdef PDC_WIDE
+        r->style = _glyph_style(attr);
+#else
+        if (direct) {
+            _pens(r, &pens);
+
+            if (r->backgr == -1) {
+                SDL_Rect back = dest;
+
+                back.w = pdc_fwidth * run;
+                SDL_LowerBlit(BACK(r), &back, SCREEN(r), &back);
+            }
+        }
+#endif
+        for (k = j; k < j + run; k++) {
+            chtype ch = blank ? (attr | ' ') : srcp[k];
+
+#ifdef CHTYPE_LONG
+            if (ch & A_ALTCHARSET && !(ch & 0xff80))
+                ch = (ch & (A_ATTRIBUTES ^ A_ALTCHARSET)) |
+                     acs_map[ch & 0x7f];
+#endif
+#ifndef PDC_WIDE
+            if (direct) {
+                _raster_cell(SCREEN(r), dest.x, dest.y,
+                             blank ? (ch & A_CHARTEXT) : ch,
+                             0, pdc_fheight, &pens);
+
+                dest.x += pdc_fwidth;
+                continue;
+            }
+#endif
+            if (r->backgr == -1)
+                SDL_LowerBlit(BACK(r), &dest, SCREEN(r), &dest);
+
+#ifdef PDC_WIDE
+            _draw_glyph(ch & A_CHARTEXT, r->style, r->foregr, r->backgr,
+                        0, pdc_fheight, SCREEN(r), &dest);
+#else
+            src.x = (ch & 0xff) % 32 * pdc_fwidth;
+            src.y = (ch & 0xff) / 32 * pdc_fheight;
+
+            _font_colors(r, r->foregr, r->backgr);
+            SDL_LowerBlit(FONT(r), &src, SCREEN(r), &dest);
+#endif
+
+            if (!blank && (ch & (A_UNDERLINE | A_LEFT | A_RIGHT)))
+                _highlight(r, &src, &dest, ch);
+
+            dest.x += pdc_fwidth;
+        }
+    }
+}
+
+/* Lines with blinking cells, so that a tick of the blink timer only
+   has to look at those. blink_span[] gives the columns of each line
+   that may hold them (first is -1 if none), and blink_rows has a bit
+   set for each line with a span. Runs are noted as they're drawn,
+   which can only widen a span, or clear it when a run covers all of
+   it; each tick narrows the spans to the cells that really blink. The
+   index only exists while A_BLINK is in SP->termattrs, and the timer
+   only runs while some line has a span. */
+
+struct blinkspan {
+    int first, last;
+};
+
+static struct blinkspan *blink_span = NULL;
+static Uint64 *blink_rows = NULL;
+static int blink_lines = 0;
+static bool blink_on = FALSE;          /* A_BLINK as of the last tick */
+static SDL_TimerID blinker_id = 0;
+
+static Uint32 _blink_timer(Uint32 interval, void *param) {
+    SDL_Event event;
+
+    event.type = SDL_USEREVENT;
+    SDL_PushEvent(&event);
+    return (interval);
+}
+
+static void _blink_start(void) {
+    if (!blinker_id)
+        blinker_id = SDL_AddTimer(500, _blink_timer, NULL);
+}
+
+static void _blink_mark(int y) {
+    if (blink_span[y].first != -1)
+        blink_rows[y >> 6] |= (Uint64)1 << (y & 63);
+    else
+        blink_rows[y >> 6] &= ~((Uint64)1 << (y & 63));
+}
+
+static void _blink_free(void) {
+    free(blink_span);
+    free(blink_rows);
+
+    blink_span = NULL;
+    blink_rows = NULL;
+    blink_lines = 0;
+}
+
+/* make an empty index for the current screen size */
+
+static bool _blink_alloc(void) {
+    int y;
+
+    _blink_free();
+
+    blink_span = malloc(SP->lines * sizeof(struct blinkspan));
+    blink_rows = calloc((SP->lines + 63) / 64, sizeof(Uint64));
+
+    if (!blink_span || !blink_rows) {
+        _blink_free();
+        return FALSE;
+    }
+
+    for (y = 0; y < SP->lines; y++)
+        blink_span[y].first = blink_span[y].last = -1;
+
+    blink_lines = SP->lines;
+
+    return TRUE;
+}
+
+/* note the blinking cells in a run of len cells from text, drawn at
+   (y, x) */
+
+static void _blink_note(int y, int x, int len, const chtype *text) {
+    struct blinkspan *s;
+    int first = -1, last = -1, i;
+
+    if (!blink_span)
+        return;
+
+    /* after a resize, the next tick rebuilds the index */
+
+    if (blink_lines != SP->lines) {
+        _blink_start();
+        return;
+    }
+
+    for (i = 0; i < len; i++)
+        if (text[i] & A_BLINK) {
+            if (first == -1)
+                first = x + i;
+            last = x + i;
+        }
+
+    s = blink_span + y;
+
+    if (first != -1) {
+        if (s->first == -1 || first < s->first)
+            s->first = first;
+        if (last > s->last)
+            s->last = last;
+
+        _blink_mark(y);
+        _blink_start();
+    } else if (s->first != -1 && x <= s->first && x + len > s->last) {
+        s->first = s->last = -1;
+        _blink_mark(y);
+    }
+}
+
+static void _blink_reverse(int i, int j) {
+    for (; i < j; i++, j--) {
+        struct blinkspan tmp = blink_span[i];
+
+        blink_span[i] = blink_span[j];
+        blink_span[j] = tmp;
+    }
+}
+
+/* rotate the spans of lines top through bottom along with the pixels,
+   as in PDC_scroll_region() */
+
+static void _blink_scroll(int top, int bottom, int n) {
+    int count = bottom - top + 1, y;
+
+    if (!blink_span || blink_lines != SP->lines)
+        return;
+
+    if (n < 0)
+        n += count;
+
+    _blink_reverse(top, top + n - 1);
+    _blink_reverse(top + n, bottom);
+    _blink_reverse(top, bottom);
+
+    for (y = top; y <= bottom; y++)
+        _blink_mark(y);
+}
+
+/* redraw the blinking cells of line y, in columns s->first through
+   s->last, and narrow s to the ones found */
+
+static void _blink_line(int y, struct blinkspan *s) {
+    const chtype *srcp = curscr->_y[y];
+    int j = s->first, last = s->last, k;
+
+    s->first = s->last = -1;
+
+    while (j >= 0 && j <= last) {
+        if (!(srcp[j] & A_BLINK)) {
+            j++;
+            continue;
+        }
+
+        for (k = j; k <= last && (srcp[k] & A_BLINK); k++)
+            ;
+
+        _draw_line(&ren, y, j, k - j, srcp + j);
+
+        if (s->first == -1)
+            s->first = j;
+        s->last = k - 1;
+
+        j = k;
+    }
+}
+
+/* update the given physical line to look like the corresponding line in
+   curscr */
+
+void PDC_transform_line(int lineno, int x, int len, const chtype *srcp) {
+    PDC_LOG(("PDC_transform_line() - called: lineno=%d\n", lineno));
+
+    _damage_ready();
+    _blink_note(lineno, x, len, srcp);
+    _draw_line(&ren, lineno, x, len, srcp);
+}
+
+/* move the pixels of lines top through bottom up by n lines (or down,
+   if n is negative) */
+
+bool PDC_scroll_region(int top, int bottom, int n) {
+    SDL_Rect dest;
+    Uint8 *pixels;
+    int bpp, pitch, width, height, y;
+
+    PDC_LOG(("PDC_scroll_region() - called: top %d bottom %d n %d\n",
+             top, bottom, n));
+
+    /* a tiled or captured background doesn't move with the text */
+
+    if (pdc_tileback)
+        return FALSE;
+
+    if (!n)
+        return TRUE;
+
+    _damage_ready();
+
+    /* take the cursor out first, so it doesn't get carried along */
+
+    if (!SP->mono && SP->cursrow >= top && SP->cursrow <= bottom)
+        PDC_transform_line(SP->cursrow, SP->curscol, 1,
+                           pdc_lastscr->_y[SP->cursrow] + SP->curscol);
+
+    if (SDL_MUSTLOCK(pdc_screen) && SDL_LockSurface(pdc_screen) < 0)
+        return FALSE;
+
+    dest.x = pdc_xoffset;
+    dest.y = pdc_fheight * top + pdc_yoffset;
+    dest.w = pdc_fwidth * SP->cols;
+    dest.h = pdc_fheight * (bottom - top + 1);
+
+    bpp = pdc_screen->format->BytesPerPixel;
+    pitch = pdc_screen->pitch;
+    width = dest.w * bpp;
+    height = dest.h - abs(n) * pdc_fheight;
+    pixels = (Uint8 *)pdc_screen->pixels + dest.y * pitch + dest.x * bpp;
+
+    if (n > 0) {
+        Uint8 *src = pixels + n * pdc_fheight * pitch;
+
+        for (y = 0; y < height; y++)
+            memmove(pixels + y * pitch, src + y * pitch, width);
+    } else {
+        Uint8 *dst = pixels - n * pdc_fheight * pitch;
+
+        for (y = height - 1; y >= 0; y--)
+            memmove(dst + y * pitch, pixels + y * pitch, width);
+    }
+
+    if (SDL_MUSTLOCK(pdc_screen))
+        SDL_UnlockSurface(pdc_screen);
+
+    for (y = top; y <= bottom; y++)
+        _damage(&ren, y, 0, SP->cols);
+
+    _blink_scroll(top, bottom, n);
+
+    return TRUE;
+}
+
+#ifndef PDC_WIDE
+
+/* With pdc_threads above 1, a big frame is split into bands of whole
+   lines, and each extra thread draws one band while the calling thread
+   draws the first. A worker never touches the shared surfaces: it
+   draws with its own copy of the font, through its own aliases of
+   pdc_screen's and pdc_tileback's pixels, and queues its own rects.
+   Bands don't overlap, so the pixels don't either. */
+
+#define MINTHREADCELLS 2048    /* smaller frames aren't worth splitting */
+
+struct worker {
+    SDL_Thread *thread;
+    SDL_sem *go;               /* posted when there's a band to draw */
+    struct render ren;
+    const FRAMERUN *runs;      /* the band */
+    int count;
+};
+
+static struct worker *workers = NULL;
+static int nworkers = 0;
+static SDL_sem *workers_done = NULL;
+static bool workers_quit = FALSE;
+static bool workers_tried = FALSE;
+
+static int _worker(void *data) {
+    struct worker *w = data;
+    int i;
+
+    for (;;) {
+        SDL_SemWait(w->go);
+
+        if (workers_quit)
+            break;
+
+        /* colors may have changed since the last frame */
+
+        w->ren.fontfg = w->ren.fontbg = -2;
+        w->ren.oldch = (chtype) (-1);
+        w->ren.foregr = w->ren.backgr = -2;
+        w->ren.damaged = FALSE;
+
+        for (i = 0; i < w->count; i++)
+            _draw_line(&w->ren, w->runs[i].y, w->runs[i].x, w->runs[i].len,
+                       w->runs[i].text);
+
+        SDL_SemPost(workers_done);
+    }
+
+    return 0;
+}
+
+/* keep *alias as a surface sharing s's pixels; returns FALSE if it
+   can't be made */
+
+static bool _alias(SDL_Surface **alias, SDL_Surface *s) {
+    SDL_Surface *a = *alias;
+
+    if (a && s && a->pixels == s->pixels && a->w == s->w && a->h == s->h
+        && a->pitch == s->pitch)
+        return TRUE;
+
+    SDL_FreeSurface(a);
+    *alias = NULL;
+
+    if (!s)
+        return TRUE;
+
+    *alias = SDL_CreateRGBSurfaceFrom(s->pixels, s->w, s->h,
+                                      s->format->BitsPerPixel, s->pitch,
+                                      s->format->Rmask, s->format->Gmask,
+                                      s->format->Bmask, s->format->Amask);
+
+    return *alias != NULL;
+}
+
+static void _free_worker(struct worker *w) {
+    SDL_FreeSurface(w->ren.font);
+    SDL_FreeSurface(w->ren.screen);
+    SDL_FreeSurface(w->ren.back);
+
+    if (w->go)
+        SDL_DestroySemaphore(w->go);
+}
+
+static void _stop_workers(void) {
+    int i;
+
+    workers_quit = TRUE;
+
+    for (i = 0; i < nworkers; i++) {
+        SDL_SemPost(workers[i].go);
+        SDL_WaitThread(workers[i].thread, NULL);
+        _free_worker(workers + i);
+    }
+
+    if (workers_done)
+        SDL_DestroySemaphore(workers_done);
+
+    free(workers);
+
+    workers = NULL;
+    nworkers = 0;
+    workers_done = NULL;
+    workers_quit = FALSE;
+    workers_tried = FALSE;
+}
+
+static void _start_threads(void) {
+    int i, n = pdc_threads - 1;
+
+    workers_tried = TRUE;
+
+    if (n < 1 || SP->mono)
+        return;
+
+    workers = calloc(n, sizeof(struct worker));
+    workers_done = SDL_CreateSemaphore(0);
+
+    if (!workers || !workers_done) {
+        _stop_workers();
+        return;
+    }
+
+    /* if a thread can't be had, make do with the ones we've got */
+
+    for (i = 0; i < n; i++) {
+        struct worker *w = workers + i;
+
+        w->ren.font = SDL_ConvertSurface(pdc_font, pdc_font->format, 0);
+        w->go = SDL_CreateSemaphore(0);
+
+        if (w->ren.font && w->go)
+            w->thread = SDL_CreateThread(_worker, "PDCurses", w);
+
+        if (!w->thread) {
+            _free_worker(w);
+            break;
+        }
+
+        nworkers++;
+    }
+
+    PDC_LOG(("_start_threads() - %d workers\n", nworkers));
+}
+
+/* hand all but the first band of the frame to the workers, and return
+   the number of runs left for the calling thread; *busy is set to the
+   number of workers started */
+
+static int _split_frame(const FRAMERUN *runs, int count, int *busy) {
+    long cells = 0, per;
+    int i;
+
+    *busy = 0;
+
+    if (pdc_screen->format->palette || SDL_MUSTLOCK(pdc_screen))
+        return count;
+
+    for (i = 0; i < count; i++)
+        cells += runs[i].len;
+
+    if (cells < MINTHREADCELLS)
+        return count;
+
+    per = cells / (nworkers + 1);
+    cells = 0;
+
+    for (i = 0; i < count; i++) {
+        if (*busy < nworkers && cells >= per * (*busy + 1) &&
+            runs[i].y != runs[i - 1].y) {
+            struct worker *w = workers + *busy;
+
+            if (!_alias(&w->ren.screen, pdc_screen) ||
+                !_alias(&w->ren.back, pdc_tileback))
+                break;
+
+            w->runs = runs + i;
+            ++*busy;
+        }
+
+        cells += runs[i].len;
+    }
+
+    for (i = 0; i < *busy; i++) {
+        struct worker *w = workers + i;
+        const FRAMERUN *end = (i + 1 < *busy) ? w[1].runs : runs + count;
+
+        w->count = end - w->runs;
+        SDL_SemPost(w->go);
+    }
+
+    return *busy ? workers[0].runs - runs : count;
+}
+
+/* wait for the workers; their damage is already in the map */
+
+static void _join_frame(int busy) {
+    int i;
+
+    for (i = 0; i < busy; i++)
+        SDL_SemWait(workers_done);
+
+    for (i = 0; i < busy; i++)
+        if (workers[i].ren.damaged)
+            ren.damaged = TRUE;
+}
+
+#endif
+
+void PDC_stop_threads(void) {
+#ifndef PDC_WIDE
+    _stop_workers();
+#endif
+    _stop_presenter();
+}
+
+/* draw a whole update, then show it all at once */
+
+bool PDC_transform_frame(const FRAMERUN *runs, int count, int cury,
+                         int curx) {
+    int i;
+#ifndef PDC_WIDE
+    int busy = 0;
+#endif
+
+    PDC_LOG(("PDC_transform_frame() - called: %d runs\n", count));
+
+    _damage_ready();
+
+    for (i = 0; i < count; i++)
+        _blink_note(runs[i].y, runs[i].x, runs[i].len, runs[i].text);
+
+#ifndef PDC_WIDE
+    if (!workers_tried)
+        _start_threads();
+
+    if (nworkers)
+        count = _split_frame(runs, count, &busy);
+#endif
+
+    for (i = 0; i < count; i++)
+        _draw_line(&ren, runs[i].y, runs[i].x, runs[i].len, runs[i].text);
+
+#ifndef PDC_WIDE
+    if (busy)
+        _join_frame(busy);
+#endif
+
+    if (SP->visibility)
+        PDC_gotoyx(cury, curx);
+
+    PDC_update_rects();
+
+    return TRUE;
+}
+
+/* called on each tick of the blink timer, and when blinking is turned
+   on or off */
+
+void PDC_blink_text(void) {
+    bool on = !!(SP->termattrs & A_BLINK);
+    bool full = (on != blink_on) || !blink_span ||
+                blink_lines != SP->lines;
+    int y, i;
+
+    ren.oldch = (chtype) (-1);
+    _damage_ready();
+
+    blinked_off = (on == blink_on) ? !blinked_off : FALSE;
+    blink_on = on;
+
+    if (!on)
+        _blink_free();
+    else if (full)
+        _blink_alloc();
+
+    /* look at the whole screen when the index is new (or can't be
+       had); otherwise, just at the lines in it */
+
+    if (full) {
+        for (y = 0; y < SP->lines; y++) {
+            struct blinkspan s;
+
+            s.first = 0;
+            s.last = SP->cols - 1;
+
+            _blink_line(y, &s);
+
+            if (blink_span) {
+                blink_span[y] = s;
+                _blink_mark(y);
+            }
+        }
+    } else
+        for (i = 0; i < (blink_lines + 63) / 64; i++) {
+            Uint64 bits = blink_rows[i];
+
+            for (y = i * 64; bits; y++, bits >>= 1)
+                if (bits & 1) {
+                    _blink_line(y, blink_span + y);
+                    _blink_mark(y);
+                }
+        }
+
+    /* the timer only runs while something can blink */
+
+    for (i = 0; blink_span && i < (blink_lines + 63) / 64; i++)
+        if (blink_rows[i])
+            break;
+
+    if (on && (!blink_span || i < (blink_lines + 63) / 64))
+        _blink_start();
+    else {
+        if (blinker_id)
+            SDL_RemoveTimer(blinker_id);
+
+        blinker_id = 0;
+        blinked_off = FALSE;
+    }
+
+    ren.oldch = (chtype) (-1);
+}
+
+/* free the state kept for each line of the screen */
+
+void PDC_free_lines(void) {
+    free(damage);
+
+    damage = NULL;
+    damage_rows = damage_cols = 0;
+
+    _blink_free();
 }
@@ -386,10 +386,12 @@ int PDC_get_key(void) {
                     if (pdc_own_window &&
                         (event.window.data2 / pdc_fheight != LINES ||
                          event.window.data1 / pdc_fwidth != COLS)) {
+                        PDC_stop_presenter();
+
                         pdc_sheight = event.window.data2;
                         pdc_swidth = event.window.data1;
 
-                        pdc_screen = SDL_GetWindowSurface(pdc_window);
+                        PDC_set_screen();
                         touchwin(curscr);
                         wrefresh(curscr);
 
@@ -402,7 +404,7 @@ int PDC_get_key(void) {
                     break;
                 case SDL_WINDOWEVENT_RESTORED:
                 case SDL_WINDOWEVENT_EXPOSED:
-                    SDL_UpdateWindowSurface(pdc_window);
+                    PDC_update_window();
                     break;
             }
             break;
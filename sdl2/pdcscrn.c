@@ -31,6 +31,8 @@ SDL_Window *pdc_window = NULL;
 SDL_Surface *pdc_screen = NULL, *pdc_font = NULL, *pdc_icon = NULL,
         *pdc_back = NULL, *pdc_tileback = NULL;
 int pdc_sheight = 0, pdc_swidth = 0, pdc_yoffset = 0, pdc_xoffset = 0;
+int pdc_threads = 0;
+int pdc_async_present = 0;
 
 SDL_Color pdc_color[256];
 Uint32 pdc_mapped[256];
@@ -44,6 +46,9 @@ static struct {
 } atrtab[PDC_COLOR_PAIRS];
 
 static void _clean(void) {
+    PDC_stop_threads();
+    PDC_free_glyphs();
+    PDC_free_lines();
 #ifdef PDC_WIDE
     if (pdc_ttffont) {
         TTF_CloseFont(pdc_ttffont);
@@ -104,6 +109,8 @@ void PDC_scr_close(void) {
 }
 
 void PDC_scr_free(void) {
+    PDC_stop_threads();
+
     if (SP)
         free(SP);
 }
@@ -232,8 +239,10 @@ int PDC_scr_open(int argc, char **argv) {
     pdc_fheight = pdc_font->h / 8;
     pdc_fwidth = pdc_font->w / 32;
 
-    if (!SP->mono)
+    if (!SP->mono) {
         pdc_flastc = pdc_font->format->palette->ncolors - 1;
+        PDC_load_glyphs();
+    }
 #endif
 
     if (pdc_own_window && !pdc_icon) {
@@ -311,6 +320,19 @@ int PDC_scr_open(int argc, char **argv) {
     SP->lines = PDC_get_rows();
     SP->cols = PDC_get_columns();
 
+    if (!pdc_threads) {
+        const char *env = getenv("PDC_THREADS");
+        pdc_threads = env ? atoi(env) : 1;
+    }
+
+    if (!pdc_async_present) {
+        const char *env = getenv("PDC_ASYNC_PRESENT");
+        pdc_async_present = env ? atoi(env) : 0;
+    }
+
+    if (pdc_own_window)
+        PDC_set_screen();
+
     SP->mouse_wait = PDC_CLICK_PERIOD;
     SP->audible = FALSE;
 
@@ -319,6 +341,7 @@ int PDC_scr_open(int argc, char **argv) {
     SP->termattrs |= A_ITALIC;
 #endif
 
+    PDC_cache_colors(-1);
     PDC_reset_prog_mode();
 
     return OK;
@@ -353,8 +376,9 @@ int PDC_resize_screen(int nlines, int ncols) {
         pdc_swidth = ncols * pdc_fwidth;
     }
 
+    PDC_stop_presenter();
     SDL_SetWindowSize(pdc_window, pdc_swidth, pdc_sheight);
-    pdc_screen = SDL_GetWindowSurface(pdc_window);
+    PDC_set_screen();
 
     if (pdc_tileback)
         PDC_retile();
@@ -386,6 +410,8 @@ void PDC_save_screen_mode(int i) {
 void PDC_init_pair(short pair, short fg, short bg) {
     atrtab[pair].f = fg;
     atrtab[pair].b = bg;
+
+    PDC_cache_colors(pair);
 }
 
 int PDC_pair_content(short pair, short *fg, short *bg) {
@@ -415,6 +441,7 @@ int PDC_init_color(short color, short red, short green, short blue) {
     pdc_mapped[color] = SDL_MapRGB(pdc_screen->format, pdc_color[color].r,
                                    pdc_color[color].g, pdc_color[color].b);
 
+    PDC_cache_colors(-1);
     wrefresh(curscr);
 
     return OK;
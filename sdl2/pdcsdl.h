@@ -14,6 +14,7 @@ PDCEX  int pdc_font_size;
 PDCEX  SDL_Window *pdc_window;
 PDCEX  SDL_Surface *pdc_screen, *pdc_font, *pdc_icon, *pdc_back;
 PDCEX  int pdc_sheight, pdc_swidth, pdc_yoffset, pdc_xoffset;
+PDCEX  int pdc_threads, pdc_async_present;
 
 extern SDL_Surface *pdc_tileback;    /* used to regenerate the background
                                         of "transparent" cells */
@@ -32,3 +33,13 @@ PDCEX  void PDC_update_rects(void);
 PDCEX  void PDC_retile(void);
 
 extern void PDC_blink_text(void);
+extern void PDC_stop_threads(void);
+extern void PDC_stop_presenter(void);
+extern void PDC_set_screen(void);
+extern void PDC_update_window(void);
+extern void PDC_cache_colors(int pair);
+extern void PDC_free_glyphs(void);
+extern void PDC_free_lines(void);
+#ifndef PDC_WIDE
+extern void PDC_load_glyphs(void);
+#endif
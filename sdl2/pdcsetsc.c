@@ -69,6 +69,7 @@ int PDC_set_blink(bool blinkon)
         if (!(SP->termattrs & A_BLINK))
         {
             SP->termattrs |= A_BLINK;
+            PDC_cache_colors(-1);
             PDC_blink_text();
         }
     }
@@ -77,6 +78,7 @@ int PDC_set_blink(bool blinkon)
         if (SP->termattrs & A_BLINK)
         {
             SP->termattrs &= ~A_BLINK;
+            PDC_cache_colors(-1);
             PDC_blink_text();
         }
     }
@@ -92,6 +94,8 @@ int PDC_set_bold(bool boldon)
     else
         SP->termattrs &= ~A_BOLD;
 
+    PDC_cache_colors(-1);
+
     return OK;
 #else
     return boldon ? ERR : OK;
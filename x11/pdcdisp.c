@@ -116,6 +116,58 @@ void PDC_gotoyx(int row, int col)
     PDC_display_cursor(SP->cursrow, SP->curscol, row, col, SP->visibility);
 }
 
+/* copy a whole update to the shared screen, and have it drawn with a
+   single request */
+
+bool PDC_transform_frame(const FRAMERUN *runs, int count, int cury, int curx)
+{
+    int i, j;
+
+    PDC_LOG(("PDC_transform_frame() - called: %d runs\n", count));
+
+    /* the shared screen holds one changed range per line, so each
+       line's runs are sent as one, along with the unchanged cells
+       between them */
+
+    for (i = 0; i < count; i = j)
+    {
+        int lineno = runs[i].y, x = runs[i].x, len;
+
+        for (j = i + 1; j < count && runs[j].y == lineno; j++)
+            ;
+
+        len = runs[j - 1].x + runs[j - 1].len - x;
+
+        XC_get_line_lock(lineno);
+
+        memcpy(Xcurscr + XCURSCR_Y_OFF(lineno) + (x * sizeof(chtype)),
+               runs[i].text, len * sizeof(chtype));
+
+        *(Xcurscr + XCURSCR_START_OFF + lineno) = x;
+        *(Xcurscr + XCURSCR_LENGTH_OFF + lineno) = len;
+
+        XC_release_line_lock(lineno);
+    }
+
+    if (count)
+        XCursesInstructAndWait(CURSES_REFRESH);
+
+    if (SP->visibility)
+        PDC_gotoyx(cury, curx);
+
+    return TRUE;
+}
+
+/* this port doesn't move screen contents; doupdate() redraws instead */
+
+bool PDC_scroll_region(int top, int bottom, int n)
+{
+    PDC_LOG(("PDC_scroll_region() - called: top %d bottom %d n %d\n",
+             top, bottom, n));
+
+    return FALSE;
+}
+
 /* update the given physical line to look like the corresponding line in
    curscr */
 
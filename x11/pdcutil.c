@@ -2,6 +2,8 @@
 
 #include "pdcx11.h"
 
+#include <time.h>
+
 #if defined(HAVE_POLL) && !defined(HAVE_USLEEP)
 # include <poll.h>
 #endif
@@ -13,6 +15,32 @@ void PDC_beep(void)
     XCursesInstruct(CURSES_BELL);
 }
 
+unsigned long PDC_ms_count(void)
+{
+    struct timeval now;
+
+    gettimeofday(&now, NULL);
+
+    return now.tv_sec * 1000UL + now.tv_usec / 1000;
+}
+
+unsigned long PDC_us_count(void)
+{
+#ifdef CLOCK_MONOTONIC
+    struct timespec now;
+
+    if (!clock_gettime(CLOCK_MONOTONIC, &now))
+        return now.tv_sec * 1000000UL + now.tv_nsec / 1000;
+#endif
+    {
+        struct timeval tv;
+
+        gettimeofday(&tv, NULL);
+
+        return tv.tv_sec * 1000000UL + tv.tv_usec;
+    }
+}
+
 void PDC_napms(int ms)
 {
     PDC_LOG(("PDC_napms() - called: ms=%d\n", ms));